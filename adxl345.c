@@ -56,8 +56,14 @@
 
 #include "adxl345.h"
 #include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
 
+#if defined(ADXL_USE_LINUX)
+#include <time.h>
+#else
 extern I2C_HandleTypeDef hi2c1;
+#endif
 
 /* --------------------------------------------------
  * Global Variables
@@ -68,10 +74,273 @@ static uint8_t fifo_ctl = 0;
 static uint8_t bw_rate = 0;
 static uint8_t int_enable = 0;
 static uint8_t axis_data[6];
+static uint8_t axis_mask = ADXL_AXIS_ALL;    //*Axes fetched by non-FIFO reads
 static uint8_t int_source;
 static uint8_t act_tap_status = 0;
 static uint8_t test;
 
+/* Bus instrumentation (all transfers, including DMA) */
+static volatile uint32_t bus_transactions = 0;
+static volatile uint32_t bus_bytes = 0;
+static volatile uint32_t bus_errors = 0;
+
+static uint32_t block_seq = 0;
+
+/* Shadow image of the configuration registers (0x1D .. 0x38), power-on values */
+static uint8_t shadow[ADXL_SHADOW_SIZE] = {
+	[BW_RATE - ADXL_SHADOW_FIRST] = 0x0A
+};
+static uint16_t config_seq = 0;
+
+/* Selected device (NULL: the default one, hi2c1 / ADXL_ADDRESS or the open Linux bus) */
+static ADXL_DeviceType *device = NULL;
+static ADXL_DeviceType default_device;       //*Default device state while another is selected
+
+/* Latest-sample cell of the selected device (seqlock, written only by readAccel()) */
+static ADXL_LatestType * volatile latest = &default_device.latest;
+
+#if !defined(ADXL_USE_LINUX)
+/* DMA FIFO drain state (drainFifoDMA) */
+static ADXL_RingType *dma_ring = NULL;
+static ADXL_BlockType *dma_block = NULL;
+static uint8_t dma_status;
+static uint8_t dma_entries;
+static uint8_t dma_index;
+static volatile uint8_t dma_busy = 0;
+#endif
+
+/* Low-latency DATA_READY mode state (lowLatencyStart) */
+static void (*ll_callback)(const ADXL_SampleType *sample) = NULL;
+static uint32_t (*ll_clock)(void) = NULL;
+static uint32_t ll_ticks_per_us = 1;
+static uint8_t ll_buf[6];
+static uint8_t ll_first, ll_len;                //*Register span of the enabled axes
+static volatile uint8_t ll_busy = 0;
+static uint32_t ll_start;
+static uint32_t ll_count, ll_missed, ll_min, ll_max;
+static uint64_t ll_sum;
+
+static void llDeliver(void);
+
+/* --------------------------------------------------
+ * Bus Access (STM32 HAL or Linux transport)
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Counts one bus transaction of 'len' data bytes.
+ */
+static inline void busCount(uint16_t len){
+	bus_transactions++;
+	bus_bytes += len;
+}
+
+/**
+ * @brief  Counts a failed transaction.
+ * @return ADXL_ERROR
+ */
+static inline uint8_t busFail(void){
+	bus_errors++;
+	return ADXL_ERROR;
+}
+
+#if !defined(ADXL_USE_LINUX)
+/**
+ * @brief  I2C handle of the selected device.
+ */
+static inline I2C_HandleTypeDef *busI2c(void){
+	return (device != NULL) ? device->i2c : &hi2c1;
+}
+
+/**
+ * @brief  8-bit (shifted) I2C address of the selected device.
+ */
+static inline uint16_t busAddress(void){
+	return (device != NULL) ? (uint16_t)(device->address << 1) : ADXL_ADDRESS;
+}
+
+/**
+ * @brief  1 if the selected device is on SPI (no DMA/IT paths).
+ */
+static inline uint8_t busSpi(void){
+	return (uint8_t)(device != NULL && device->bus == ADXL_BUS_SPI);
+}
+
+#if defined(HAL_SPI_MODULE_ENABLED)
+#define SPI_READ 0x80
+#define SPI_MULTIBYTE 0x40
+
+/**
+ * @brief  One SPI register access with the chip select held low.
+ */
+static uint8_t spiTransfer(uint8_t header, uint8_t *data, uint16_t len, uint8_t read){
+	HAL_StatusTypeDef status;
+
+	if(len > 1) header |= SPI_MULTIBYTE;
+	HAL_GPIO_WritePin(device->cs_port, device->cs_pin, GPIO_PIN_RESET);
+	status = HAL_SPI_Transmit(device->spi, &header, 1, TIMEOUT);
+	if(status == HAL_OK){
+		status = read ? HAL_SPI_Receive(device->spi, data, len, TIMEOUT) : HAL_SPI_Transmit(device->spi, data, len, TIMEOUT);
+	}
+	HAL_GPIO_WritePin(device->cs_port, device->cs_pin, GPIO_PIN_SET);
+	return (status == HAL_OK) ? ADXL_OK : ADXL_ERROR;
+}
+#endif
+#endif
+
+/**
+ * @brief  Writes consecutive registers in one bus transaction.
+ * @param  reg_address: First register address
+ * @param  data: Values to write
+ * @param  len: Number of registers
+ * @return ADXL_OK on success, ADXL_ERROR on failure
+ */
+static uint8_t busWrite(uint8_t reg_address, uint8_t *data, uint16_t len){
+	busCount(len);
+#if defined(ADXL_USE_LINUX)
+	if (adxlLinuxWrite(reg_address, data, len) != ADXL_OK) return busFail();
+	return ADXL_OK;
+#else
+#if defined(HAL_SPI_MODULE_ENABLED)
+	if (busSpi()) return (spiTransfer(reg_address, data, len, 0) == ADXL_OK) ? ADXL_OK : busFail();
+#endif
+	//* I2C_MEMADD_SIZE_8BIT: 8Bits memory size address
+	if (HAL_I2C_Mem_Write(busI2c(), busAddress(), reg_address, I2C_MEMADD_SIZE_8BIT, data, len, TIMEOUT) != HAL_OK) return busFail();
+	return ADXL_OK;
+#endif
+}
+
+/**
+ * @brief  Reads consecutive registers in one bus transaction.
+ * @param  reg_address: First register address
+ * @param  data: Buffer for the values
+ * @param  len: Number of registers
+ * @return ADXL_OK on success, ADXL_ERROR on failure
+ */
+static uint8_t busRead(uint8_t reg_address, uint8_t *data, uint16_t len){
+	busCount(len);
+#if defined(ADXL_USE_LINUX)
+	if (adxlLinuxRead(reg_address, data, len) != ADXL_OK) return busFail();
+	return ADXL_OK;
+#else
+#if defined(HAL_SPI_MODULE_ENABLED)
+	if (busSpi()) return (spiTransfer(SPI_READ | reg_address, data, len, 1) == ADXL_OK) ? ADXL_OK : busFail();
+#endif
+	//* I2C_MEMADD_SIZE_8BIT: 8Bits memory size address
+	if (HAL_I2C_Mem_Read(busI2c(), busAddress(), reg_address, I2C_MEMADD_SIZE_8BIT, data, len, TIMEOUT) != HAL_OK) return busFail();
+	return ADXL_OK;
+#endif
+}
+
+/**
+ * @brief  Reports whether a DMA/IT transfer started by the driver is in flight.
+ * @return 1 if busy (drainFifoDMA or low-latency read), 0 otherwise
+ */
+uint8_t adxlBusy(void){
+#if defined(ADXL_USE_LINUX)
+	return ll_busy;
+#else
+	return (uint8_t)(dma_busy || ll_busy);
+#endif
+}
+
+/* --------------------------------------------------
+ * Device Selection
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Copies the per-device driver state into a handle.
+ */
+static void deviceSave(ADXL_DeviceType *dev){
+	memcpy(dev->shadow, shadow, sizeof(shadow));
+	dev->staged[0] = power_ctl;
+	dev->staged[1] = data_format;
+	dev->staged[2] = fifo_ctl;
+	dev->staged[3] = bw_rate;
+	dev->staged[4] = int_enable;
+	dev->axis_mask = axis_mask;
+	dev->config_seq = config_seq;
+	dev->block_seq = block_seq;
+#if defined(ADXL_USE_LINUX)
+	if(dev == &default_device) dev->fd = adxlLinuxCurrent(&dev->bus, &dev->address, &dev->sim);
+#endif
+}
+
+/**
+ * @brief  Restores the per-device driver state from a handle.
+ */
+static void deviceLoad(const ADXL_DeviceType *dev){
+	memcpy(shadow, dev->shadow, sizeof(shadow));
+	power_ctl = dev->staged[0];
+	data_format = dev->staged[1];
+	fifo_ctl = dev->staged[2];
+	bw_rate = dev->staged[3];
+	int_enable = dev->staged[4];
+	axis_mask = dev->axis_mask;
+	config_seq = dev->config_seq;
+	block_seq = dev->block_seq;
+#if defined(ADXL_USE_LINUX)
+	adxlLinuxAttach(dev->fd, dev->bus, dev->address, dev->sim);
+#endif
+}
+
+/**
+ * @brief  Sets the driver state of a new handle to the power-on values.
+ * @param  dev: Device handle (bus fields and stage pointers are left untouched)
+ * @return None
+ */
+void adxlDeviceReset(ADXL_DeviceType *dev){
+	memset(dev->shadow, 0, sizeof(dev->shadow));
+	dev->shadow[BW_RATE - ADXL_SHADOW_FIRST] = 0x0A;
+	memset(dev->staged, 0, sizeof(dev->staged));
+	dev->axis_mask = ADXL_AXIS_ALL;
+	dev->config_seq = 0;
+	dev->block_seq = 0;
+	dev->latest.seq = 0;
+}
+
+/**
+ * @brief  Makes a device the target of every driver function.
+ * @param  dev: Device handle (adxl345_probe.c), or NULL for the default device
+ * @return ADXL_OK, or ADXL_ERROR while a DMA/IT transfer is in flight or
+ *         low-latency mode is running
+ * @note   The configuration shadow, staged register values, axis mask,
+ *         block/config sequence numbers and the readLatest() cell are kept per
+ *         device; the glitch/health stages use the handle's own instances.
+ *         DMA drain state only lives for one transfer. Low-latency mode is tied
+ *         to the selected device's INT pin: stop it before switching.
+ */
+uint8_t adxlSelect(ADXL_DeviceType *dev){
+	ADXL_DeviceType *next = (dev != NULL) ? dev : &default_device;
+
+	if(dev == device) return ADXL_OK;
+	if(adxlBusy() || ll_callback != NULL) return ADXL_ERROR;
+
+	deviceSave((device != NULL) ? device : &default_device);
+	deviceLoad(next);
+	latest = &next->latest;
+	device = dev;
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Returns the selected device.
+ * @return Device handle, or NULL for the default device
+ */
+ADXL_DeviceType *adxlSelected(void){
+	return device;
+}
+
+/**
+ * @brief  Returns the bus instrumentation counters.
+ * @param  stats: Pointer to ADXL_BusStatsType structure
+ * @return None
+ */
+void getBusStats(ADXL_BusStatsType *stats){
+	stats->transactions = bus_transactions;
+	stats->bytes = bus_bytes;
+	stats->errors = bus_errors;
+}
+
 /* --------------------------------------------------
  * Register Handling Functions
  * --------------------------------------------------*/
@@ -81,16 +350,17 @@ static uint8_t test;
  * @param  reg_address Register address to write to.
  * @param  value The value to be written to the register.
  * @return None
- * @note   This function uses I2C communication.
+ * @note   This function uses I2C communication (or the Linux transport).
  *         If the write operation fails, an error message is printed.
  */
 void writeRegister(uint8_t reg_address, uint8_t value){
-    uint8_t data[2] = {reg_address, value};
-
-    if (HAL_I2C_Master_Transmit(&hi2c1, ADXL_ADDRESS, data, 2, TIMEOUT) != HAL_OK) {
+    if (busWrite(reg_address, &value, 1) != ADXL_OK) {
     	printf("Error: Failed to write register 0x%02X\r\n", reg_address);
     }
     else{
+    	if (reg_address >= ADXL_SHADOW_FIRST && reg_address <= ADXL_SHADOW_LAST) {
+    		shadow[reg_address - ADXL_SHADOW_FIRST] = value;
+    	}
     	printf("Success: Written to register: 0x%02X\r\n", reg_address);
     }
 }
@@ -104,8 +374,7 @@ void writeRegister(uint8_t reg_address, uint8_t value){
  * @return None
  */
 void readRegister(uint8_t reg_address, uint8_t *value, uint8_t num){
-	//* I2C_MEMADD_SIZE_8BIT: 8Bits memory size address
-    if (HAL_I2C_Mem_Read(&hi2c1, ADXL_ADDRESS, reg_address, I2C_MEMADD_SIZE_8BIT, value, num, TIMEOUT) != HAL_OK) {
+    if (busRead(reg_address, value, num) != ADXL_OK) {
     	printf("Error: Failed to read from register 0x%02X\r\n", reg_address);
     }
     else{
@@ -114,16 +383,92 @@ void readRegister(uint8_t reg_address, uint8_t *value, uint8_t num){
 }
 
 
+/**
+ * @brief  Reads consecutive registers in one bus transaction, without printing.
+ * @param  reg_address: First register
+ * @param  data: Destination buffer
+ * @param  len: Number of registers
+ * @return ADXL_OK on success, ADXL_ERROR on bus failure
+ * @note   Reading DATAX0..DATAZ1 pops the FIFO and reading INT_SOURCE clears
+ *         latched interrupts: keep those registers out of configuration reads.
+ */
+uint8_t readBurst(uint8_t reg_address, uint8_t *data, uint8_t len){
+	return busRead(reg_address, data, len);
+}
+
+
 /**
  * @brief  Reads acceleration data from a register.
  * @param  reg_address: Register address
- * @return None
+ * @return ADXL_OK on success, ADXL_ERROR on bus failure
+ * @note   Always reads all six bytes: in FIFO modes this pops exactly one entry.
  */
-void readValue(uint8_t reg_address){
-	//* I2C_MEMADD_SIZE_8BIT: 8Bits memory size address
-    if (HAL_I2C_Mem_Read(&hi2c1, ADXL_ADDRESS, reg_address, I2C_MEMADD_SIZE_8BIT, (uint8_t*)axis_data, 6, TIMEOUT) != HAL_OK) {
+uint8_t readValue(uint8_t reg_address){
+    if (busRead(reg_address, axis_data, 6) != ADXL_OK) {
     	printf("Error: Failed to read from register 0x%02X\r\n", reg_address);
+    	return ADXL_ERROR;
     }
+    return ADXL_OK;
+}
+
+
+/**
+ * @brief  Finds the contiguous data-register span covering the given axes.
+ * @param  mask: ADXL_AXIS_X | ADXL_AXIS_Y | ADXL_AXIS_Z
+ * @param  first: Receives the index of the first axis (0 = X)
+ * @param  len: Receives the span length in bytes
+ * @return None
+ */
+static void axisSpan(uint8_t mask, uint8_t *first, uint8_t *len){
+	uint8_t lo = (mask & ADXL_AXIS_X) ? 0 : (mask & ADXL_AXIS_Y) ? 1 : 2;
+	uint8_t hi = (mask & ADXL_AXIS_Z) ? 2 : (mask & ADXL_AXIS_Y) ? 1 : 0;
+
+	*first = lo;
+	*len = (uint8_t)((hi - lo + 1) * 2);
+}
+
+
+/**
+ * @brief  Reads only the data registers of the given axes (non-FIFO reads).
+ * @param  mask: Axes to fetch
+ * @return ADXL_OK on success, ADXL_ERROR on bus failure
+ * @note   One transaction over the contiguous span, e.g. DATAZ0..DATAZ1 for Z.
+ *         With the FIFO enabled all six bytes are read, so every call pops
+ *         exactly one entry.
+ */
+static uint8_t readSpan(uint8_t mask){
+	uint8_t first, len;
+
+	if((fifo_ctl & FIFO_TRIGGER) != FIFO_BYPASS) return readValue(DATAX0);
+
+	axisSpan(mask, &first, &len);
+	if (busRead(DATAX0 + first * 2, &axis_data[first * 2], len) != ADXL_OK) {
+		printf("Error: Failed to read from register 0x%02X\r\n", DATAX0 + first * 2);
+		return ADXL_ERROR;
+	}
+	return ADXL_OK;
+}
+
+
+/**
+ * @brief  Selects the axes fetched by readAccel() and low-latency mode.
+ * @param  mask: ADXL_AXIS_X | ADXL_AXIS_Y | ADXL_AXIS_Z (0: all)
+ * @return None
+ * @note   FIFO drains still read six bytes per entry (partial reads would not
+ *         pop the FIFO reliably); blocks carry the disabled axes in 'axes_off'
+ *         so the processing stages skip them.
+ */
+void setAxisMask(uint8_t mask){
+	axis_mask = (mask & ADXL_AXIS_ALL) ? (mask & ADXL_AXIS_ALL) : ADXL_AXIS_ALL;
+}
+
+
+/**
+ * @brief  Returns the axes selected with setAxisMask().
+ * @return Axis mask
+ */
+uint8_t getAxisMask(void){
+	return axis_mask;
 }
 
 
@@ -147,7 +492,7 @@ void adxlInit(ADXL_InitType *initConfig){
 			initConfig->AUTOSLEEP_MODE |
 			initConfig->MEASURE_SET;
 	/* Optional */
-	//Wakeup(WAKEUP_8Hz);
+	//WakeUp(WAKEUP_8Hz);
 
 	/* Setting */
 	if(initConfig->AUTOSLEEP_MODE == AUTOSLEEPMODE_ON) configureAutosleep();
@@ -176,6 +521,7 @@ void adxlInit(ADXL_InitType *initConfig){
 
 	writeRegister(FIFO_CTL, fifo_ctl);
 
+	config_seq++;
 }
 
 
@@ -199,6 +545,24 @@ void adxlTest(){
 	readRegister(DEVID, &test, 1); //*check reading 0xE5(229)
 }
 
+/**
+ * @brief  Reads DEVID without printing and checks it.
+ * @return ADXL_OK if the device answers with ADXL_DEVID_VALUE, ADXL_ERROR otherwise
+ * @note   The value read is kept for getDevId().
+ */
+uint8_t checkDevId(void){
+	if(busRead(DEVID, &test, 1) != ADXL_OK) return ADXL_ERROR;
+	return (test == ADXL_DEVID_VALUE) ? ADXL_OK : ADXL_ERROR;
+}
+
+/**
+ * @brief  Returns the last DEVID value read by adxlTest() or checkDevId().
+ * @return Device ID (0xE5 for an ADXL345)
+ */
+uint8_t getDevId(void){
+	return test;
+}
+
 /* --------------------------------------------------
  * adxl345.c Initialization Function
  * --------------------------------------------------*/
@@ -384,12 +748,32 @@ void configureTapAndFreefall(ADXL_INTType *INTConfig){
  * Read Axis Data
  * --------------------------------------------------*/
 
+/**
+ * @brief  Returns the current sensitivity.
+ * @return mg per LSB in Q8 (1000 = 3.9 mg/LSB)
+ * @note   Full resolution keeps 3.9 mg/LSB at every range;
+ *         10-bit mode doubles it per range step.
+ */
+uint16_t getScale(void){
+	return scaleOf(data_format);
+}
+
+/**
+ * @brief  Returns the sensitivity for a given DATA_FORMAT value.
+ * @param  format: DATA_FORMAT register value (e.g. ADXL_BlockType.data_format)
+ * @return mg per LSB in Q8
+ */
+uint16_t scaleOf(uint8_t format){
+	if(format & FULL_RESOLUTION) return 1000;
+	return (uint16_t)(1000U << (format & 0x03));
+}
+
 /**
  * @brief  Reads X-axis acceleration data.
  * @return X-axis acceleration value
  */
 int16_t read_X(void){
-	readValue(DATAX0);
+	readSpan(ADXL_AXIS_X);
 	return ((axis_data[1] << 8) | axis_data[0]);
 }
 
@@ -398,7 +782,7 @@ int16_t read_X(void){
  * @return Y-axis acceleration value
  */
 int16_t read_Y(void){
-	readValue(DATAX0);
+	readSpan(ADXL_AXIS_Y);
 	return ((axis_data[3] << 8) | axis_data[2]);
 }
 
@@ -407,6 +791,635 @@ int16_t read_Y(void){
  * @return Z-axis acceleration value
  */
 int16_t read_Z(void){
-	readValue(DATAX0);
+	readSpan(ADXL_AXIS_Z);
 	return ((axis_data[5] << 8) | axis_data[4]);
 }
+
+/* --------------------------------------------------
+ * Justification
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Returns the right shift that undoes JUSTIFY_MSB (0 when right-justified).
+ */
+static inline uint8_t justifyShift(void){
+	if(!(data_format & JUSTIFY_MSB)) return 0;
+	return (data_format & FULL_RESOLUTION) ? (uint8_t)(6 - (data_format & 0x03)) : 6;
+}
+
+/**
+ * @brief  Right-justifies one left-justified (JUSTIFY_MSB) sample.
+ * @param  sample: Raw sample
+ * @return None
+ */
+static void justifySample(ADXL_SampleType *sample){
+	uint8_t shift = justifyShift();
+
+	sample->x >>= shift;
+	sample->y >>= shift;
+	sample->z >>= shift;
+}
+
+/**
+ * @brief  Right-justifies left-justified (JUSTIFY_MSB) samples in a block.
+ * @param  block: Block holding raw samples
+ * @param  count: Number of samples
+ * @return None
+ * @note   Block samples and the latest-sample cell are always right-justified,
+ *         so scaleOf() applies to them whatever DATA_FORMAT was in effect.
+ */
+static void justifyBlock(ADXL_BlockType *block, uint8_t count){
+	if(justifyShift() == 0) return;
+
+	for(uint8_t i = 0; i < count; i++) justifySample(&block->samples[i]);
+}
+
+/* --------------------------------------------------
+ * Latest Sample (seqlock)
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Writer side of the latest-sample seqlock.
+ * @param  sample: Sample to publish
+ * @return None
+ */
+static void publishLatest(const ADXL_SampleType *sample){
+	ADXL_LatestType *cell = latest;
+
+	cell->seq++;                                    //* odd: update in progress
+	atomic_thread_fence(memory_order_release);
+
+	cell->sample.x = sample->x;
+	cell->sample.y = sample->y;
+	cell->sample.z = sample->z;
+
+	atomic_thread_fence(memory_order_release);
+	cell->seq++;                                    //* even: update complete
+}
+
+/**
+ * @brief  Reads the enabled axes in one transaction and publishes them to the latest-sample cell.
+ * @return None
+ * @note   This is an acquisition path (like drainFifo()). Use one of them from a
+ *         single context only; readers use readLatest() instead of read_X/Y/Z.
+ *         Axes disabled with setAxisMask() are not read and published as 0.
+ *         Samples are published right-justified, as on the FIFO paths.
+ */
+void readAccel(void){
+	ADXL_SampleType sample;
+
+	if(readSpan(axis_mask) != ADXL_OK) return;
+
+	sample.x = (axis_mask & ADXL_AXIS_X) ? (int16_t)((axis_data[1] << 8) | axis_data[0]) : 0;
+	sample.y = (axis_mask & ADXL_AXIS_Y) ? (int16_t)((axis_data[3] << 8) | axis_data[2]) : 0;
+	sample.z = (axis_mask & ADXL_AXIS_Z) ? (int16_t)((axis_data[5] << 8) | axis_data[4]) : 0;
+	justifySample(&sample);
+	publishLatest(&sample);
+}
+
+/**
+ * @brief  Copies the most recent sample published by readAccel().
+ * @param  sample: Pointer to store the sample (untouched on failure)
+ * @return Number of samples published so far, 0 if no sample yet or the
+ *         cell stayed busy for ADXL_LATEST_RETRIES attempts
+ * @note   No bus access and no locking: the copy is retried if readAccel()
+ *         updated the cell while it was being read. The retries are bounded,
+ *         so an interrupt that preempted the writer gets 0 instead of
+ *         spinning forever.
+ */
+uint32_t readLatest(ADXL_SampleType *sample){
+	const ADXL_LatestType *cell = latest;           //*One device per call, even across adxlSelect()
+	ADXL_SampleType copy;
+	uint32_t seq;
+
+	for(uint8_t retry = 0; retry < ADXL_LATEST_RETRIES; retry++){
+		seq = cell->seq;
+		if(seq & 1U) continue;                      //* writer in progress
+		atomic_thread_fence(memory_order_acquire);
+
+		copy.x = cell->sample.x;
+		copy.y = cell->sample.y;
+		copy.z = cell->sample.z;
+
+		atomic_thread_fence(memory_order_acquire);
+		if(seq != cell->seq) continue;
+
+		if(seq == 0) return 0;
+		*sample = copy;
+		return seq >> 1;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------
+ * FIFO Drain
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Reads every FIFO entry into a sample block.
+ * @param  block: Destination block (e.g. from adxlPoolAlloc())
+ * @return Number of samples read
+ * @note   One 6-byte read per entry, as required to pop the FIFO.
+ *         The newest sample is also published to the latest-sample cell.
+ */
+uint8_t drainFifo(ADXL_BlockType *block){
+	return drainFifoN(block, ADXL_BLOCK_SAMPLES);
+}
+
+/**
+ * @brief  Stamps a block with its sequence number and the configuration in effect.
+ */
+static void stampBlock(ADXL_BlockType *block){
+	block->seq = block_seq++;
+	block->config_seq = config_seq;
+	block->data_format = data_format;
+	block->bw_rate = bw_rate;
+	block->axes_off = (uint8_t)(ADXL_AXIS_ALL & ~axis_mask);
+}
+
+/**
+ * @brief  Reads at most 'max' FIFO entries into a sample block.
+ * @param  block: Destination block
+ * @param  max: Maximum number of samples (1 .. ADXL_BLOCK_SAMPLES)
+ * @return Number of samples read
+ * @note   Entries beyond 'max' stay in the FIFO for the next call.
+ */
+uint8_t drainFifoN(ADXL_BlockType *block, uint8_t max){
+	uint8_t status;
+	uint8_t entries;
+	uint8_t i;
+
+	block->count = 0;
+	if(busRead(FIFO_STATUS, &status, 1) != ADXL_OK) return 0;
+
+	entries = status & FIFO_ENTRIES_MASK;
+	if(max > ADXL_BLOCK_SAMPLES) max = ADXL_BLOCK_SAMPLES;
+	if(entries > max) entries = max;
+
+	for(i = 0; i < entries; i++){
+		if(readValue(DATAX0) != ADXL_OK) break;
+
+		block->samples[i].x = (int16_t)((axis_data[1] << 8) | axis_data[0]);
+		block->samples[i].y = (int16_t)((axis_data[3] << 8) | axis_data[2]);
+		block->samples[i].z = (int16_t)((axis_data[5] << 8) | axis_data[4]);
+	}
+
+	justifyBlock(block, i);
+	block->count = i;
+	stampBlock(block);
+	if(i > 0) publishLatest(&block->samples[i - 1]);
+	return i;
+}
+
+#if !defined(ADXL_USE_LINUX)
+/* --------------------------------------------------
+ * FIFO Drain (DMA, zero-copy into ring slots)
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Decodes a slot in place and commits it to the ring.
+ * @return None
+ */
+static void dmaCommit(void){
+	ADXL_BlockType *block = dma_block;
+
+	/* Raw FIFO bytes are little-endian X0 X1 Y0 Y1 Z0 Z1: already int16 samples
+	 * on Cortex-M */
+	justifyBlock(block, dma_index);
+
+	block->count = dma_index;
+	stampBlock(block);
+	if(dma_index > 0) publishLatest(&block->samples[dma_index - 1]);
+
+	adxlRingPublish(dma_ring);
+	dma_busy = 0;
+	ADXL_DrainCpltCallback(block);
+}
+
+/**
+ * @brief  Starts a non-blocking FIFO drain straight into the next ring slot.
+ * @param  ring: Consumer ring (policy ADXL_RING_DROP or ADXL_RING_OVERWRITE)
+ * @return ADXL_OK if the transfer started, ADXL_ERROR if busy or on bus failure
+ * @note   Call from the WATERMARK interrupt. Forward HAL_I2C_MemRxCpltCallback()
+ *         and HAL_I2C_ErrorCallback() to ADXL_I2C_MemRxCpltCallback() and
+ *         ADXL_I2C_ErrorCallback(). The slot is committed on completion and
+ *         ADXL_DrainCpltCallback() is called.
+ */
+uint8_t drainFifoDMA(ADXL_RingType *ring){
+	if(dma_busy || ll_busy || busSpi()) return ADXL_ERROR;
+	dma_busy = 1;
+
+	dma_ring = ring;
+	dma_block = NULL;
+	dma_index = 0;
+
+	busCount(1);
+	if(HAL_I2C_Mem_Read_DMA(busI2c(), busAddress(), FIFO_STATUS, I2C_MEMADD_SIZE_8BIT, &dma_status, 1) != HAL_OK){
+		dma_busy = 0;
+		return ADXL_ERROR;
+	}
+	return ADXL_OK;
+}
+
+/**
+ * @brief  DMA completion handler for drainFifoDMA().
+ * @param  hi2c: I2C handle passed to HAL_I2C_MemRxCpltCallback()
+ * @return None
+ */
+void ADXL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	if(hi2c == busI2c() && ll_busy){
+		llDeliver();
+		return;
+	}
+	if(hi2c != busI2c() || !dma_busy) return;
+
+	if(dma_block == NULL){
+		/* FIFO_STATUS arrived: claim the slot the samples will land in */
+		dma_entries = dma_status & FIFO_ENTRIES_MASK;
+		if(dma_entries > ADXL_BLOCK_SAMPLES) dma_entries = ADXL_BLOCK_SAMPLES;
+
+		dma_block = (dma_entries > 0) ? adxlRingClaim(dma_ring) : NULL;
+		if(dma_block == NULL){
+			dma_busy = 0;                           //*Empty FIFO or ring full (dropped)
+			return;
+		}
+	}
+	else{
+		dma_index++;
+	}
+
+	if(dma_index == dma_entries){
+		dmaCommit();
+		return;
+	}
+
+	/* One 6-byte transfer per FIFO entry, directly into samples[dma_index] */
+	busCount(6);
+	if(HAL_I2C_Mem_Read_DMA(busI2c(), busAddress(), DATAX0, I2C_MEMADD_SIZE_8BIT,
+			(uint8_t*)&dma_block->samples[dma_index], 6) != HAL_OK){
+		dmaCommit();                                //*Keep what arrived
+	}
+}
+
+/**
+ * @brief  DMA error handler for drainFifoDMA().
+ * @param  hi2c: I2C handle passed to HAL_I2C_ErrorCallback()
+ * @return None
+ */
+void ADXL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+	if(hi2c == busI2c() && ll_busy){
+		ll_missed++;
+		ll_busy = 0;
+		return;
+	}
+	if(hi2c != busI2c() || !dma_busy) return;
+
+	printf("Error: FIFO DMA transfer failed\r\n");
+	if(dma_block != NULL) dmaCommit();              //*Commit the samples already received
+	else dma_busy = 0;
+}
+
+/**
+ * @brief  Called when a drained block has been committed to the ring.
+ * @param  block: Committed ring slot
+ * @return None
+ * @note   Weak: override to wake the consumer task.
+ */
+__weak void ADXL_DrainCpltCallback(ADXL_BlockType *block){
+	(void)block;
+}
+#endif /* !ADXL_USE_LINUX */
+
+/* --------------------------------------------------
+ * Low-Latency Mode (DATA_READY -> DMA -> callback)
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Default latency clock: DWT cycles on the MCU, nanoseconds on Linux.
+ */
+static uint32_t defaultClock(void){
+#if defined(ADXL_USE_LINUX)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#else
+	return DWT->CYCCNT;
+#endif
+}
+
+/**
+ * @brief  Decodes the low-latency sample, records its latency and delivers it.
+ * @return None
+ */
+static void llDeliver(void){
+	ADXL_SampleType sample;
+	uint32_t latency = ll_clock() - ll_start;
+
+	sample.x = (int16_t)((ll_buf[1] << 8) | ll_buf[0]);
+	sample.y = (int16_t)((ll_buf[3] << 8) | ll_buf[2]);
+	sample.z = (int16_t)((ll_buf[5] << 8) | ll_buf[4]);
+	justifySample(&sample);
+	publishLatest(&sample);
+
+	if(ll_count == 0 || latency < ll_min) ll_min = latency;
+	if(latency > ll_max) ll_max = latency;
+	ll_sum += latency;
+	ll_count++;
+
+	ll_busy = 0;
+	if(ll_callback != NULL) ll_callback(&sample);
+}
+
+/**
+ * @brief  Enters low-latency mode: DATA_READY on its own pin, one sample per interrupt.
+ * @param  pin: INT1 (1) or INT2 (2), dedicated to DATA_READY
+ * @param  callback: Called with each sample (interrupt context on the MCU)
+ * @return None
+ * @note   Call ADXL_LowLatency_EXTI() first thing in HAL_GPIO_EXTI_Callback() for
+ *         that pin, and forward HAL_I2C_MemRxCpltCallback() as for drainFifoDMA().
+ *         Use FIFO_BYPASS: every conversion is read as soon as it is ready.
+ */
+void lowLatencyStart(uint8_t pin, void (*callback)(const ADXL_SampleType *sample)){
+	if(ll_clock == NULL) lowLatencySetClock(NULL, 0);
+
+	ll_count = 0;
+	ll_missed = 0;
+	ll_min = 0;
+	ll_max = 0;
+	ll_sum = 0;
+	ll_busy = 0;
+	ll_callback = callback;
+	axisSpan(((fifo_ctl & FIFO_TRIGGER) != FIFO_BYPASS) ? ADXL_AXIS_ALL : axis_mask, &ll_first, &ll_len);
+	memset(ll_buf, 0, sizeof(ll_buf));              //*Disabled axes read as 0
+
+	INT_Map(DATA_READY_INT, pin);
+	int_enable |= DATA_READY_ON;
+	writeRegister(INT_ENABLE, int_enable);
+
+	readValue(DATAX0);                              //*Clear a pending DATA_READY so the pin re-arms
+}
+
+/**
+ * @brief  Leaves low-latency mode and disables the DATA_READY interrupt.
+ * @return None
+ */
+void lowLatencyStop(void){
+	ll_callback = NULL;
+	int_enable &= (uint8_t)~DATA_READY_ON;
+	writeRegister(INT_ENABLE, int_enable);
+}
+
+/**
+ * @brief  Replaces the clock used for latency measurement.
+ * @param  clock: Free-running 32-bit tick source (NULL: DWT cycles / CLOCK_MONOTONIC ns)
+ * @param  ticks_per_us: Ticks per microsecond of 'clock' (ignored when clock is NULL)
+ * @return None
+ * @note   Pass adxlSimClockNs, 1000 to measure against the simulator's timing model.
+ */
+void lowLatencySetClock(uint32_t (*clock)(void), uint32_t ticks_per_us){
+	if(clock == NULL){
+		ll_clock = defaultClock;
+#if defined(ADXL_USE_LINUX)
+		ll_ticks_per_us = 1000;
+#else
+		ll_ticks_per_us = SystemCoreClock / 1000000U;
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	}
+	else{
+		ll_clock = clock;
+		ll_ticks_per_us = ticks_per_us;
+	}
+}
+
+/**
+ * @brief  DATA_READY interrupt entry: starts the data read immediately (enabled axes only).
+ * @return None
+ * @note   No printf and no blocking call on the MCU: the DMA read is pre-armed
+ *         with a static buffer and completes in ADXL_I2C_MemRxCpltCallback().
+ */
+void ADXL_LowLatency_EXTI(void){
+	if(ll_callback == NULL) return;
+
+	uint32_t now = ll_clock();
+
+#if defined(ADXL_USE_LINUX)
+	ll_start = now;
+	ll_busy = 1;
+	if(busRead(DATAX0 + ll_first * 2, &ll_buf[ll_first * 2], ll_len) != ADXL_OK){
+		ll_missed++;
+		ll_busy = 0;
+		return;
+	}
+	llDeliver();
+#else
+	if(ll_busy || dma_busy || busSpi()){
+		ll_missed++;                                //*Previous sample still in flight (or no DMA path)
+		return;
+	}
+	ll_start = now;
+	ll_busy = 1;
+	busCount(ll_len);
+	if(HAL_I2C_Mem_Read_DMA(busI2c(), busAddress(), DATAX0 + ll_first * 2, I2C_MEMADD_SIZE_8BIT,
+			&ll_buf[ll_first * 2], ll_len) != HAL_OK){
+		ll_missed++;
+		ll_busy = 0;
+	}
+#endif
+}
+
+/**
+ * @brief  Returns latency and jitter statistics of low-latency mode.
+ * @param  stats: Pointer to ADXL_LatencyType structure
+ * @return None
+ * @note   Latency runs from interrupt entry to sample delivery.
+ */
+void lowLatencyStats(ADXL_LatencyType *stats){
+	uint32_t div = (ll_ticks_per_us != 0) ? ll_ticks_per_us : 1;
+
+	stats->count = ll_count;
+	stats->missed = ll_missed;
+	stats->min_ns = (uint32_t)((uint64_t)ll_min * 1000U / div);
+	stats->max_ns = (uint32_t)((uint64_t)ll_max * 1000U / div);
+	stats->mean_ns = (ll_count != 0) ? (uint32_t)(ll_sum * 1000U / div / ll_count) : 0;
+	stats->jitter_ns = stats->max_ns - stats->min_ns;
+}
+
+/* --------------------------------------------------
+ * Shadow Image / Hot Reconfiguration
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Returns the shadow image of registers 0x1D .. 0x38.
+ * @return Pointer to ADXL_SHADOW_SIZE bytes (index = register - ADXL_SHADOW_FIRST)
+ */
+const uint8_t *getShadow(void){
+	return shadow;
+}
+
+/**
+ * @brief  Returns the current configuration generation (see ADXL_BlockType.config_seq).
+ * @return Configuration sequence number
+ */
+uint16_t getConfigSeq(void){
+	return config_seq;
+}
+
+/**
+ * @brief  Writes consecutive configuration registers in one bus transaction.
+ * @param  reg_address: First register
+ * @param  data: Values to write
+ * @param  len: Number of registers
+ * @return ADXL_OK on success, ADXL_ERROR on failure
+ * @note   Updates the shadow image and the cached BW_RATE / POWER_CTL /
+ *         INT_ENABLE / DATA_FORMAT / FIFO_CTL values.
+ */
+uint8_t writeBurst(uint8_t reg_address, const uint8_t *data, uint8_t len){
+	if(busWrite(reg_address, (uint8_t*)data, len) != ADXL_OK){
+		printf("Error: Failed to write registers 0x%02X..0x%02X\r\n", reg_address, reg_address + len - 1);
+		return ADXL_ERROR;
+	}
+
+	for(uint8_t i = 0; i < len; i++){
+		uint8_t reg = reg_address + i;
+		if(reg >= ADXL_SHADOW_FIRST && reg <= ADXL_SHADOW_LAST) shadow[reg - ADXL_SHADOW_FIRST] = data[i];
+	}
+
+	bw_rate = shadow[BW_RATE - ADXL_SHADOW_FIRST];
+	power_ctl = shadow[POWER_CTL - ADXL_SHADOW_FIRST];
+	int_enable = shadow[INT_ENABLE - ADXL_SHADOW_FIRST];
+	data_format = shadow[DATA_FORMAT - ADXL_SHADOW_FIRST];
+	fifo_ctl = shadow[FIFO_CTL - ADXL_SHADOW_FIRST];
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Marks a configuration change in the stream (increments config_seq).
+ * @return None
+ */
+void markConfigChange(void){
+	config_seq++;
+}
+
+/**
+ * @brief  Pops every FIFO entry without publishing it.
+ * @return Number of entries dropped
+ * @note   If anything was dropped, the next block sequence number is skipped,
+ *         so consumers see the loss as a gap.
+ */
+uint8_t discardFifo(void){
+	uint8_t status;
+	uint8_t i;
+
+	if(busRead(FIFO_STATUS, &status, 1) != ADXL_OK) return 0;
+	for(i = 0; i < (status & FIFO_ENTRIES_MASK); i++){
+		if(readValue(DATAX0) != ADXL_OK) break;
+	}
+	if(i > 0) block_seq++;
+	return i;
+}
+
+/**
+ * @brief  Returns the current time in milliseconds (HAL tick / CLOCK_MONOTONIC).
+ */
+static uint32_t nowMs(void){
+#if defined(ADXL_USE_LINUX)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U);
+#else
+	return HAL_GetTick();
+#endif
+}
+
+/**
+ * @brief  Waits for the next conversion, at most TIMEOUT ms.
+ * @return ADXL_OK when a new sample is ready, ADXL_ERROR on timeout or bus failure
+ * @note   With the FIFO enabled the entry count is polled (the FIFO must be
+ *         empty on entry). In bypass INT_SOURCE.DATA_READY is polled, which
+ *         also clears latched tap/activity/free-fall bits.
+ */
+static uint8_t waitDataReady(void){
+	uint32_t t0 = nowMs();
+	uint8_t fifo = (uint8_t)((fifo_ctl & FIFO_TRIGGER) != FIFO_BYPASS);
+	uint8_t value;
+
+	do{
+		if(busRead(fifo ? FIFO_STATUS : INT_SOURCE, &value, 1) != ADXL_OK) return ADXL_ERROR;
+		if(fifo ? (value & FIFO_ENTRIES_MASK) : (value & DATA_READY_INT)) return ADXL_OK;
+	} while(nowMs() - t0 < TIMEOUT);
+	return ADXL_ERROR;
+}
+
+/**
+ * @brief  Changes range/rate/mode without resetting the sensor.
+ * @param  initConfig: New configuration (same fields as adxlInit)
+ * @param  tail: Receives the samples still in the FIFO, taken with the old
+ *               configuration (may be NULL to discard them)
+ * @return ADXL_OK, or ADXL_ERROR if initConfig is NULL or a register write failed
+ * @note   1. Drains the FIFO (old scale, old config_seq).
+ *         2. Waits for the next conversion (DATA_READY) and adds it to 'tail',
+ *            so the writes start at a sample boundary.
+ *         3. Writes only the registers that change (stops at the first failure).
+ *         4. Drops the samples converted while the registers were written
+ *            (they may use either configuration); the next block sequence
+ *            number is skipped so the gap is visible.
+ *         5. Increments config_seq: every later block carries the new value.
+ *         Compared to adxlInit(), no register is reset and the FIFO is not lost.
+ *         After a failed write, steps 4 and 5 still run if an earlier register
+ *         was changed, and ADXL_ERROR is returned.
+ */
+uint8_t adxlReconfigure(ADXL_InitType *initConfig, ADXL_BlockType *tail){
+	static ADXL_BlockType scratch;
+	ADXL_BlockType *old = (tail != NULL) ? tail : &scratch;
+	const uint8_t reg[4] = { DATA_FORMAT, BW_RATE, FIFO_CTL, POWER_CTL };
+	uint8_t value[4];
+	uint8_t changed = 0, written = 0, result = ADXL_OK;
+
+	if(initConfig == NULL) return ADXL_ERROR;
+
+	value[0] = (uint8_t)((data_format & (SELF_TEST_ON | INT_ACTIVELOW | JUSTIFY_MSB)) |
+			initConfig->FULL_RES | initConfig->RANGE);
+	value[1] = initConfig->LP_MODE | initConfig->BWRATE;
+	value[2] = (uint8_t)((fifo_ctl & (FIFO_TRIGGER_INT2 | 0x1F)) | initConfig->FIFO_MODE);
+	value[3] = (uint8_t)((power_ctl & 0x03) | initConfig->LINK_MODE |
+			initConfig->AUTOSLEEP_MODE | initConfig->MEASURE_SET);
+
+	/* 1. Everything already converted belongs to the old configuration */
+	drainFifo(old);
+
+	for(uint8_t i = 0; i < 4; i++) changed |= (uint8_t)(shadow[reg[i] - ADXL_SHADOW_FIRST] != value[i]);
+	if(!changed) return ADXL_OK;
+
+	/* 2. Write right after a conversion; that sample still has the old configuration */
+	if(waitDataReady() == ADXL_OK && readValue(DATAX0) == ADXL_OK){
+		if(old->count < ADXL_BLOCK_SAMPLES){
+			ADXL_SampleType *sample = &old->samples[old->count++];
+			sample->x = (int16_t)((axis_data[1] << 8) | axis_data[0]);
+			sample->y = (int16_t)((axis_data[3] << 8) | axis_data[2]);
+			sample->z = (int16_t)((axis_data[5] << 8) | axis_data[4]);
+			justifySample(sample);
+			publishLatest(sample);
+		}
+		else block_seq++;                           //*No room in 'tail': show the loss
+	}
+
+	/* 3. Apply only the differences (autosleep thresholds first) */
+	if(initConfig->AUTOSLEEP_MODE == AUTOSLEEPMODE_ON &&
+			!(shadow[POWER_CTL - ADXL_SHADOW_FIRST] & AUTOSLEEPMODE_ON)) configureAutosleep();
+
+	for(uint8_t i = 0; i < 4 && result == ADXL_OK; i++){
+		if(shadow[reg[i] - ADXL_SHADOW_FIRST] == value[i]) continue;
+		result = writeBurst(reg[i], &value[i], 1);
+		if(result == ADXL_OK) written++;
+	}
+	if(written == 0) return result;                 //*Sensor unchanged
+
+	/* 4. Samples converted during the writes are ambiguous: drop them (seq gap) */
+	discardFifo();
+
+	/* 5. Mark the change in the stream */
+	config_seq++;
+	return result;
+}
@@ -28,6 +28,7 @@
  *
  * @ attention
  *  - The I2C handle must be initialized in 'main.c'.
+ *  - On Linux, build with -DADXL_USE_LINUX and open the bus with adxlLinuxOpenI2C()/adxlLinuxOpenSPI().
  *  - If interrupt handling is required, implement 'HAL_GPIO_EXTI_Callback()'.
  *
  *******************************************************************************
@@ -43,7 +44,13 @@
  * adxl345.h
  * --------------------------------------------------*/
 
+#if defined(ADXL_USE_LINUX)
+#include "adxl345_linux.h"           //*Linux i2c-dev / spidev transport
+#else
 #include "main.h"
+#endif
+#include "adxl345_types.h"
+#include "adxl345_ring.h"
 
 /* --------------------------------------------------
  * 1. ADXL Init Typedef
@@ -73,11 +80,29 @@ typedef struct{
 } ADXL_INTType;
 
 
+typedef struct{
+	uint32_t count;      //*Samples delivered
+	uint32_t missed;     //*DATA_READY edges dropped (read still in flight or bus error)
+	uint32_t min_ns;
+	uint32_t max_ns;     //*Worst-case interrupt-to-callback latency
+	uint32_t mean_ns;
+	uint32_t jitter_ns;  //*max - min
+} ADXL_LatencyType;
+
+
+typedef struct{
+	uint32_t transactions; //*Bus transfers started (blocking, IT and DMA)
+	uint32_t bytes;        //*Register bytes transferred (payload, without address bytes)
+	uint32_t errors;       //*Failed blocking transfers
+} ADXL_BusStatsType;
+
+
 /* --------------------------------------------------
  * 2. register address define
  * --------------------------------------------------*/
 
 #define DEVID 0x00           //*Device ID
+#define ADXL_DEVID_VALUE 0xE5 //*DEVID of every ADXL345
 #define THRESH_TAP 0x1D      //*Tap threshold
 #define OFSX 0x1E            //*X-axis offset
 #define OFSY 0x1F            //*Y-axis offset
@@ -116,24 +141,49 @@ typedef struct{
 #define ADXL_ADDRESS 0x53<<1 //*ADXL345 Slave address
 #define TIMEOUT 100
 
+#define ADXL_OK 0
+#define ADXL_ERROR 1
+
+#define ADXL_SHADOW_FIRST THRESH_TAP //*Shadow image covers 0x1D .. 0x38
+#define ADXL_SHADOW_LAST FIFO_CTL
+#define ADXL_SHADOW_SIZE (ADXL_SHADOW_LAST - ADXL_SHADOW_FIRST + 1)
+#define ADXL_LATEST_RETRIES 16      //*readLatest() attempts before giving up
+
+/** 0x27 - ACT_INACT_CTL  **/
+
+#define ACT_AC_COUPLED 128
+#define INACT_AC_COUPLED 8
+#define ACT_AXES_SHIFT 4             //*Activity axes = ADXL_AXIS_xxx << 4
+#define INACT_AXES_SHIFT 0
+
 /** 0x2A - TAP_AXES  **/
 
+#define ADXL_AXIS_X 4                //*Same bit order as TAP_AXES / ACT_INACT_CTL
+#define ADXL_AXIS_Y 2
+#define ADXL_AXIS_Z 1
+#define ADXL_AXIS_ALL 7
+
 /** 0x2B - ACT_TAP_STATUS  **/
 
+#define ASLEEP_STATUS 8
+
 /** 0x2C - BW_RATE  **/
 
 #define LP_NORMAL 0
 #define LP_LOWPOWER 16
 
-#define BWRATE_6_25 7
-#define BWRATE_12_5 8
-#define BWRATE_25 9
-#define BWRATE_50 10
-#define BWRATE_100 11
-#define BWRATE_200 12
-#define BWRATE_400 13
-#define BWRATE_800 14
-#define BWRATE_1600 15
+/* Rate codes per the datasheet (0x0A = 100 Hz). Earlier versions were one code
+ * high, so BWRATE_100 ran at 200 Hz. */
+#define BWRATE_6_25 6
+#define BWRATE_12_5 7
+#define BWRATE_25 8
+#define BWRATE_50 9
+#define BWRATE_100 10
+#define BWRATE_200 11
+#define BWRATE_400 12
+#define BWRATE_800 13
+#define BWRATE_1600 14
+#define BWRATE_3200 15
 
 
 /** 0x2D - POWER_CTL  **/
@@ -234,6 +284,52 @@ typedef struct{
 
 /** 0x39 - FIFO_STATUS  **/
 
+#define FIFO_TRIG_EVENT 128
+#define FIFO_ENTRIES_MASK 63
+
+/** Device handle (adxlSelect(), adxl345_probe.c) **/
+
+#define ADXL_BUS_I2C 0
+#define ADXL_BUS_SPI 1
+
+#define ADXL_I2C_ADDRESS_ALT 0x1D    //*ALT ADDRESS pin high (0x53 when low)
+
+typedef struct{
+	volatile uint32_t seq;           //*Odd while readAccel() updates the sample
+	volatile ADXL_SampleType sample;
+} ADXL_LatestType;
+
+struct ADXL_Glitch;                  //*adxl345_glitch.h
+struct ADXL_Health;                  //*adxl345_health.h
+
+typedef struct{
+	uint8_t bus;                     //*ADXL_BUS_I2C / ADXL_BUS_SPI
+	uint8_t address;                 //*I2C 7-bit address (0x53 or 0x1D)
+	uint8_t devid;                   //*DEVID read at discovery
+	uint8_t bus_index;               //*Position in the probed bus table
+#if defined(ADXL_USE_LINUX)
+	int fd;                          //*i2c-dev / spidev descriptor (shared by devices on one adapter)
+	uint8_t sim;                     //*1: simulator stand-in
+#else
+	I2C_HandleTypeDef *i2c;
+#if defined(HAL_SPI_MODULE_ENABLED)
+	SPI_HandleTypeDef *spi;
+	GPIO_TypeDef *cs_port;
+	uint16_t cs_pin;
+#endif
+#endif
+	/* Stage state of this device (NULL: the stage uses its global instance) */
+	struct ADXL_Glitch *glitch;      //*adxlStageGlitch()
+	struct ADXL_Health *health;      //*adxlStageHealth()
+	/* Driver state kept here while another device is selected */
+	uint8_t shadow[ADXL_SHADOW_SIZE];
+	uint8_t staged[5];
+	uint8_t axis_mask;
+	uint16_t config_seq;
+	uint32_t block_seq;
+	ADXL_LatestType latest;          //*readLatest() cell, used in place while selected
+} ADXL_DeviceType;
+
 
 /* --------------------------------------------------
  * 4. function define
@@ -245,8 +341,12 @@ void adxlInit(ADXL_InitType *initConfig);
 void readAccel(void);
 void resetRegisters(void);
 void adxlTest(void);
+uint8_t checkDevId(void);
+uint8_t getDevId(void);
+uint8_t readBurst(uint8_t reg_address, uint8_t *data, uint8_t len);
 
 void configureAutosleep(void);
+void WakeUp(uint8_t wakeup);
 void Self_Test(uint8_t self_test);
 void Int_Invert(uint8_t int_invert);
 void Justify(uint8_t justify);
@@ -263,5 +363,39 @@ void configureTapAndFreefall(ADXL_INTType *INTConfig);
 int16_t read_X(void);
 int16_t read_Y(void);
 int16_t read_Z(void);
+void setAxisMask(uint8_t mask);
+uint8_t getAxisMask(void);
+uint16_t getScale(void);
+uint16_t scaleOf(uint8_t format);
+
+const uint8_t *getShadow(void);
+uint16_t getConfigSeq(void);
+void getBusStats(ADXL_BusStatsType *stats);
+uint8_t adxlBusy(void);
+void adxlDeviceReset(ADXL_DeviceType *dev);
+uint8_t adxlSelect(ADXL_DeviceType *dev);
+ADXL_DeviceType *adxlSelected(void);
+void markConfigChange(void);
+uint8_t writeBurst(uint8_t reg_address, const uint8_t *data, uint8_t len);
+uint8_t adxlReconfigure(ADXL_InitType *initConfig, ADXL_BlockType *tail);
+
+uint32_t readLatest(ADXL_SampleType *sample);
+
+uint8_t drainFifo(ADXL_BlockType *block);
+uint8_t drainFifoN(ADXL_BlockType *block, uint8_t max);
+uint8_t discardFifo(void);
+
+void lowLatencyStart(uint8_t pin, void (*callback)(const ADXL_SampleType *sample));
+void lowLatencyStop(void);
+void lowLatencySetClock(uint32_t (*clock)(void), uint32_t ticks_per_us);
+void ADXL_LowLatency_EXTI(void);
+void lowLatencyStats(ADXL_LatencyType *stats);
+
+#if !defined(ADXL_USE_LINUX)
+uint8_t drainFifoDMA(ADXL_RingType *ring);
+void ADXL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void ADXL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+void ADXL_DrainCpltCallback(ADXL_BlockType *block);
+#endif
 
 #endif /* INC_ADXL345_H_ */
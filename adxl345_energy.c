@@ -0,0 +1,171 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_energy.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Energy model for sensor, bus and MCU power budgets (adxl345_energy.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Currents are the ADXL345 datasheet typical values (VS = 2.5 V, Tables 7/8),
+ *     indexed by the rate code actually written to BW_RATE.
+ *   - Sleep current is taken as the normal-mode current at the nearest output
+ *     rate to the wake-up rate (8/4/2/1 Hz): the datasheet gives no table.
+ *   - The sensor term assumes the state is constant between two updates: call
+ *     adxlEnergyUpdate() whenever the configuration changes.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_energy.h"
+#include <string.h>
+
+/* --------------------------------------------------
+ * Datasheet Currents
+ * --------------------------------------------------*/
+
+/* Normal mode, index = rate code 0x0 (0.10 Hz) .. 0xF (3200 Hz), uA */
+static const uint8_t normal_ua[16] = {
+	23, 23, 23, 23, 34, 40, 45, 50, 60, 90, 140, 140, 140, 140, 90, 140
+};
+
+/* Low-power mode, rate codes 0x7 (12.5 Hz) .. 0xC (400 Hz), uA */
+static const uint8_t lowpower_ua[16] = {
+	23, 23, 23, 23, 34, 40, 45, 34, 40, 45, 50, 60, 90, 140, 90, 140
+};
+
+/* Sleep, index = wake-up bits: 8, 4, 2, 1 Hz (nearest normal-mode rate) */
+static const uint8_t sleep_ua[4] = { 45, 40, 34, 23 };
+
+static const ADXL_EnergyModelType default_model = {
+	ADXL_ENERGY_SUPPLY_MV,
+	ADXL_ENERGY_BUS_NJ_PER_BYTE,
+	ADXL_ENERGY_BUS_NJ_PER_TRANSACTION,
+	ADXL_ENERGY_MCU_NJ_PER_WAKEUP,
+};
+
+/**
+ * @brief  Datasheet supply current of the sensor for a configuration.
+ * @param  bw_rate: BW_RATE register value (rate code and LOW_POWER bit)
+ * @param  power_ctl: POWER_CTL register value (MEASURE, SLEEP, WAKEUP bits)
+ * @return Current in nA
+ * @note   Low-power mode only applies to 12.5 .. 400 Hz; outside that range the
+ *         sensor runs in normal mode.
+ */
+uint32_t adxlEnergySensorNa(uint8_t bw_rate, uint8_t power_ctl){
+	uint8_t rate = bw_rate & 0x0F;
+
+	if(!(power_ctl & MEASURE_ON)) return ADXL_ENERGY_STANDBY_NA;
+	if(power_ctl & SLEEPMODE_ON) return sleep_ua[power_ctl & 0x03] * 1000U;
+	if(bw_rate & LP_LOWPOWER) return lowpower_ua[rate] * 1000U;
+	return normal_ua[rate] * 1000U;
+}
+
+/**
+ * @brief  Current sensor draw from the shadow image.
+ */
+static uint32_t sensorNow(const ADXL_EnergyType *energy){
+	const uint8_t *shadow = getShadow();
+	uint8_t power_ctl = shadow[POWER_CTL - ADXL_SHADOW_FIRST];
+
+	if(energy->asleep) power_ctl |= SLEEPMODE_ON;
+	return adxlEnergySensorNa(shadow[BW_RATE - ADXL_SHADOW_FIRST], power_ctl);
+}
+
+/* --------------------------------------------------
+ * Accounting
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Starts energy accounting.
+ * @param  energy: Pointer to ADXL_EnergyType structure
+ * @param  model: Coefficients (NULL: defaults)
+ * @param  now_ms: Current time in milliseconds
+ * @return None
+ */
+void adxlEnergyInit(ADXL_EnergyType *energy, const ADXL_EnergyModelType *model, uint32_t now_ms){
+	memset(energy, 0, sizeof(*energy));
+	energy->model = (model != NULL) ? *model : default_model;
+	energy->start_ms = now_ms;
+	energy->last_ms = now_ms;
+	getBusStats(&energy->bus_base);
+}
+
+/**
+ * @brief  Integrates the sensor current up to now with the present configuration.
+ * @param  energy: Pointer to ADXL_EnergyType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return None
+ * @note   Call just before and after every configuration change.
+ */
+void adxlEnergyUpdate(ADXL_EnergyType *energy, uint32_t now_ms){
+	uint32_t dt = now_ms - energy->last_ms;
+
+	energy->sensor_nc += (uint64_t)sensorNow(energy) * dt / 1000U;
+	energy->last_ms = now_ms;
+}
+
+/**
+ * @brief  Counts one MCU wake-up (call from the wake-up interrupt or idle hook).
+ * @param  energy: Pointer to ADXL_EnergyType structure
+ * @return None
+ */
+void adxlEnergyWakeup(ADXL_EnergyType *energy){
+	energy->wakeups++;
+}
+
+/**
+ * @brief  Records an auto-sleep transition (from ACTIVITY/INACTIVITY interrupts).
+ * @param  energy: Pointer to ADXL_EnergyType structure
+ * @param  asleep: 1 when the sensor entered sleep, 0 when it woke
+ * @param  now_ms: Time of the transition
+ * @return None
+ */
+void adxlEnergySetAsleep(ADXL_EnergyType *energy, uint8_t asleep, uint32_t now_ms){
+	adxlEnergyUpdate(energy, now_ms);
+	energy->asleep = asleep;
+}
+
+/**
+ * @brief  Energy so far and average current.
+ * @param  energy: Pointer to ADXL_EnergyType structure
+ * @param  now_ms: Current time in milliseconds
+ * @param  report: Pointer to ADXL_EnergyReportType structure
+ * @return None
+ */
+void adxlEnergyReport(ADXL_EnergyType *energy, uint32_t now_ms, ADXL_EnergyReportType *report){
+	const ADXL_EnergyModelType *m = &energy->model;
+	ADXL_BusStatsType bus;
+	uint64_t sensor_nj, bus_nj, mcu_nj;
+
+	adxlEnergyUpdate(energy, now_ms);
+	getBusStats(&bus);
+
+	sensor_nj = energy->sensor_nc * m->supply_mv / 1000U;                      //*nC * mV = pJ
+	bus_nj = (uint64_t)(bus.bytes - energy->bus_base.bytes) * m->bus_nj_per_byte +
+			(uint64_t)(bus.transactions - energy->bus_base.transactions) * m->bus_nj_per_transaction;
+	mcu_nj = (uint64_t)energy->wakeups * m->mcu_nj_per_wakeup;
+
+	report->elapsed_ms = now_ms - energy->start_ms;
+	report->sensor_uj = (uint32_t)(sensor_nj / 1000U);
+	report->bus_uj = (uint32_t)(bus_nj / 1000U);
+	report->mcu_uj = (uint32_t)(mcu_nj / 1000U);
+	report->total_uj = (uint32_t)((sensor_nj + bus_nj + mcu_nj) / 1000U);
+	report->sensor_ua = sensorNow(energy) / 1000U;
+
+	/* I = E / (V * t): nJ / (mV * ms) = mA */
+	report->average_ua = (report->elapsed_ms != 0) ?
+			(uint32_t)((sensor_nj + bus_nj + mcu_nj) * 1000U / ((uint64_t)m->supply_mv * report->elapsed_ms)) : 0;
+}
+
+/**
+ * @brief  Projected battery life at the measured average current.
+ * @param  report: Result of adxlEnergyReport()
+ * @param  capacity_mah: Battery capacity
+ * @return Hours (UINT32_MAX if the average current is zero)
+ */
+uint32_t adxlEnergyLifeHours(const ADXL_EnergyReportType *report, uint32_t capacity_mah){
+	if(report->average_ua == 0) return UINT32_MAX;
+	return (uint32_t)((uint64_t)capacity_mah * 1000U / report->average_ua);
+}
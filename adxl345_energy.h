@@ -0,0 +1,97 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_energy.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Energy model for sensor, bus and MCU power budgets (adxl345_energy.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Sensor: datasheet supply current for the BW_RATE code, LOW_POWER bit,
+ *     standby and sleep (wake-up rate), integrated over time
+ *   - Bus: bytes and transactions from getBusStats(), times a per-byte and a
+ *     per-transaction energy
+ *   - MCU: wake-ups counted with adxlEnergyWakeup(), times an energy per wake-up
+ *   - adxlEnergyReport() gives the energy so far, the average current and the
+ *     projected battery life; adxlEnergySensorNa() prices a configuration
+ *     before it is deployed
+ *   - Replay: run a recording through the simulator (-DADXL_USE_LINUX) and pass
+ *     simulated time (adxlSim.now_us / 1000) to compare configurations
+ *
+ *  @usage
+ *   ADXL_EnergyType energy;
+ *   adxlEnergyInit(&energy, NULL, HAL_GetTick());
+ *   wake-up ISR:       adxlEnergyWakeup(&energy);
+ *   config change:     adxlEnergyUpdate(&energy, HAL_GetTick());
+ *   adxlEnergyReport(&energy, HAL_GetTick(), &report);
+ *   hours = adxlEnergyLifeHours(&report, 220);              // CR2032
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_ENERGY_H_
+#define INC_ADXL345_ENERGY_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Energy setting value define
+ * --------------------------------------------------*/
+
+/* Default coefficients: 3.3 V, 400 kHz I2C with 4.7 kOhm pull-ups, Cortex-M4 at 84 MHz */
+#define ADXL_ENERGY_SUPPLY_MV 3300
+#define ADXL_ENERGY_BUS_NJ_PER_BYTE 26
+#define ADXL_ENERGY_BUS_NJ_PER_TRANSACTION 80
+#define ADXL_ENERGY_MCU_NJ_PER_WAKEUP 1300
+
+#define ADXL_ENERGY_STANDBY_NA 100       //*Datasheet standby current
+
+/* --------------------------------------------------
+ * 2. Energy Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint16_t supply_mv;
+	uint16_t bus_nj_per_byte;
+	uint16_t bus_nj_per_transaction;
+	uint32_t mcu_nj_per_wakeup;
+} ADXL_EnergyModelType;
+
+typedef struct{
+	ADXL_EnergyModelType model;
+	uint32_t start_ms;
+	uint32_t last_ms;
+	uint64_t sensor_nc;              //*Sensor charge so far, nC (nA * s)
+	uint32_t wakeups;
+	uint8_t asleep;                  //*Sensor in auto-sleep (set by the application)
+	ADXL_BusStatsType bus_base;      //*Bus counters at adxlEnergyInit()
+} ADXL_EnergyType;
+
+typedef struct{
+	uint32_t elapsed_ms;
+	uint32_t sensor_uj;
+	uint32_t bus_uj;
+	uint32_t mcu_uj;
+	uint32_t total_uj;
+	uint32_t average_ua;             //*Total energy as current from supply_mv
+	uint32_t sensor_ua;              //*Current sensor draw in the present state
+} ADXL_EnergyReportType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlEnergyInit(ADXL_EnergyType *energy, const ADXL_EnergyModelType *model, uint32_t now_ms);
+void adxlEnergyUpdate(ADXL_EnergyType *energy, uint32_t now_ms);
+void adxlEnergyWakeup(ADXL_EnergyType *energy);
+void adxlEnergySetAsleep(ADXL_EnergyType *energy, uint8_t asleep, uint32_t now_ms);
+void adxlEnergyReport(ADXL_EnergyType *energy, uint32_t now_ms, ADXL_EnergyReportType *report);
+uint32_t adxlEnergyLifeHours(const ADXL_EnergyReportType *report, uint32_t capacity_mah);
+uint32_t adxlEnergySensorNa(uint8_t bw_rate, uint8_t power_ctl);
+
+#endif /* INC_ADXL345_ENERGY_H_ */
@@ -0,0 +1,317 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_frame.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Serial framing of sample blocks (adxl345_frame.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - The decoder works on whole read() buffers: sync search uses memchr and
+ *     complete frames are validated in place, without a per-byte state machine.
+ *   - CRC uses a 16-entry nibble table (32 bytes of flash on the MCU side).
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_frame.h"
+#include <string.h>
+
+static const uint16_t crc_nibble[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/* --------------------------------------------------
+ * Encoding
+ * --------------------------------------------------*/
+
+/**
+ * @brief  CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).
+ * @param  data: Bytes to check
+ * @param  len: Number of bytes
+ * @return CRC value
+ */
+uint16_t adxlFrameCrc(const uint8_t *data, uint16_t len){
+	uint16_t crc = 0xFFFF;
+
+	while(len--){
+		crc = (uint16_t)((crc << 4) ^ crc_nibble[(crc >> 12) ^ (*data >> 4)]);
+		crc = (uint16_t)((crc << 4) ^ crc_nibble[(crc >> 12) ^ (*data & 0x0F)]);
+		data++;
+	}
+	return crc;
+}
+
+/**
+ * @brief  Adds sync, header and CRC around a payload already placed at out[4].
+ */
+static uint16_t finishFrame(uint8_t type, uint8_t len, uint8_t *out){
+	out[0] = ADXL_FRAME_SYNC0;
+	out[1] = ADXL_FRAME_SYNC1;
+	out[2] = type;
+	out[3] = len;
+
+	uint16_t crc = adxlFrameCrc(&out[2], (uint16_t)(len + 2U));
+	out[4 + len] = (uint8_t)crc;
+	out[5 + len] = (uint8_t)(crc >> 8);
+	return (uint16_t)(len + ADXL_FRAME_OVERHEAD);
+}
+
+/**
+ * @brief  Builds one frame.
+ * @param  type: Frame type (ADXL_FRAME_*)
+ * @param  payload: Payload bytes
+ * @param  len: Payload length
+ * @param  out: Output buffer (at least len + ADXL_FRAME_OVERHEAD bytes)
+ * @return Frame length in bytes
+ */
+uint16_t adxlFrameEncode(uint8_t type, const uint8_t *payload, uint8_t len, uint8_t *out){
+	memcpy(&out[4], payload, len);
+	return finishFrame(type, len, out);
+}
+
+/**
+ * @brief  Builds an ADXL_FRAME_BLOCK frame from a sample block.
+ * @param  block: Block to send
+ * @param  out: Output buffer (ADXL_FRAME_MAX bytes)
+ * @return Frame length in bytes
+ */
+uint16_t adxlFrameEncodeBlock(const ADXL_BlockType *block, uint8_t *out){
+	uint8_t *p = &out[4];
+	uint16_t count = (block->count > ADXL_BLOCK_SAMPLES) ? ADXL_BLOCK_SAMPLES : block->count;
+
+	p[0] = (uint8_t)block->seq;
+	p[1] = (uint8_t)(block->seq >> 8);
+	p[2] = (uint8_t)(block->seq >> 16);
+	p[3] = (uint8_t)(block->seq >> 24);
+	p[4] = (uint8_t)block->config_seq;
+	p[5] = (uint8_t)(block->config_seq >> 8);
+	p[6] = block->data_format;
+	p[7] = block->bw_rate;
+	p[8] = block->axes_off;
+	p += ADXL_FRAME_BLOCK_HEADER;
+
+	for(uint16_t i = 0; i < count; i++){
+		const ADXL_SampleType *s = &block->samples[i];
+		*p++ = (uint8_t)s->x; *p++ = (uint8_t)((uint16_t)s->x >> 8);
+		*p++ = (uint8_t)s->y; *p++ = (uint8_t)((uint16_t)s->y >> 8);
+		*p++ = (uint8_t)s->z; *p++ = (uint8_t)((uint16_t)s->z >> 8);
+	}
+
+	return finishFrame(ADXL_FRAME_BLOCK, (uint8_t)(ADXL_FRAME_BLOCK_HEADER + count * 6U), out);
+}
+
+/**
+ * @brief  Unpacks an ADXL_FRAME_BLOCK payload.
+ * @param  payload: Payload bytes
+ * @param  len: Payload length
+ * @param  block: Destination block ('node' is left untouched)
+ * @return 1 on success, 0 if the payload is malformed
+ */
+uint8_t adxlFrameParseBlock(const uint8_t *payload, uint8_t len, ADXL_BlockType *block){
+	if(len < ADXL_FRAME_BLOCK_HEADER || (len - ADXL_FRAME_BLOCK_HEADER) % 6 != 0 ||
+			(len - ADXL_FRAME_BLOCK_HEADER) / 6 > ADXL_BLOCK_SAMPLES) return 0;
+
+	block->seq = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+			((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+	block->config_seq = (uint16_t)(payload[4] | (payload[5] << 8));
+	block->data_format = payload[6];
+	block->bw_rate = payload[7];
+	block->axes_off = payload[8];
+	block->count = (uint16_t)((len - ADXL_FRAME_BLOCK_HEADER) / 6);
+
+	const uint8_t *p = &payload[ADXL_FRAME_BLOCK_HEADER];
+	for(uint16_t i = 0; i < block->count; i++, p += 6){
+		block->samples[i].x = (int16_t)(p[0] | (p[1] << 8));
+		block->samples[i].y = (int16_t)(p[2] | (p[3] << 8));
+		block->samples[i].z = (int16_t)(p[4] | (p[5] << 8));
+	}
+	return 1;
+}
+
+/* --------------------------------------------------
+ * Health frames
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Packs a status into an ADXL_FRAME_HEALTH frame.
+ * @param  status: Health status
+ * @param  out: Output buffer (at least ADXL_HEALTH_PAYLOAD + ADXL_FRAME_OVERHEAD bytes)
+ * @return Frame length in bytes
+ */
+uint16_t adxlHealthEncode(const ADXL_HealthStatusType *status, uint8_t *out){
+	uint8_t payload[ADXL_HEALTH_PAYLOAD];
+	uint8_t *p = payload;
+	const uint16_t *words[4] = { status->noise, status->floor, status->baseline, status->max_run };
+
+	*p++ = status->flags;
+	*p++ = status->latched;
+	*p++ = status->stuck_axes;
+	*p++ = status->saturated_axes;
+	for(uint8_t w = 0; w < 4; w++){
+		for(uint8_t a = 0; a < 3; a++){
+			*p++ = (uint8_t)words[w][a];
+			*p++ = (uint8_t)(words[w][a] >> 8);
+		}
+	}
+	*p++ = (uint8_t)status->windows;
+	*p++ = (uint8_t)(status->windows >> 8);
+	*p++ = (uint8_t)(status->windows >> 16);
+	*p++ = (uint8_t)(status->windows >> 24);
+	*p++ = (uint8_t)status->devid_checks;
+	*p++ = (uint8_t)(status->devid_checks >> 8);
+	*p++ = (uint8_t)status->devid_failures;
+	*p++ = (uint8_t)(status->devid_failures >> 8);
+
+	return adxlFrameEncode(ADXL_FRAME_HEALTH, payload, ADXL_HEALTH_PAYLOAD, out);
+}
+
+/**
+ * @brief  Unpacks an ADXL_FRAME_HEALTH payload.
+ * @param  payload: Payload bytes
+ * @param  len: Payload length
+ * @param  status: Destination
+ * @return 1 on success, 0 if the payload is malformed
+ */
+uint8_t adxlHealthParse(const uint8_t *payload, uint8_t len, ADXL_HealthStatusType *status){
+	const uint8_t *p = payload;
+	uint16_t *words[4] = { status->noise, status->floor, status->baseline, status->max_run };
+
+	if(len != ADXL_HEALTH_PAYLOAD) return 0;
+
+	status->flags = *p++;
+	status->latched = *p++;
+	status->stuck_axes = *p++;
+	status->saturated_axes = *p++;
+	for(uint8_t w = 0; w < 4; w++){
+		for(uint8_t a = 0; a < 3; a++, p += 2) words[w][a] = (uint16_t)(p[0] | (p[1] << 8));
+	}
+	status->windows = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	status->devid_checks = (uint16_t)(p[4] | (p[5] << 8));
+	status->devid_failures = (uint16_t)(p[6] | (p[7] << 8));
+	return 1;
+}
+
+/* --------------------------------------------------
+ * Duty-cycle frames
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Packs the idle-hook figures into an ADXL_FRAME_DUTY frame.
+ * @param  duty: Figures of the last window (adxlIdleStats())
+ * @param  out: Output buffer (at least ADXL_DUTY_PAYLOAD + ADXL_FRAME_OVERHEAD bytes)
+ * @return Frame length in bytes
+ */
+uint16_t adxlDutyEncode(const ADXL_DutyType *duty, uint8_t *out){
+	uint8_t payload[ADXL_DUTY_PAYLOAD];
+	uint8_t *p = payload;
+	const uint32_t words[3] = { duty->awake_us_per_s, duty->wakeups_per_s, duty->us_per_wakeup };
+
+	for(uint8_t w = 0; w < 3; w++){
+		*p++ = (uint8_t)words[w];
+		*p++ = (uint8_t)(words[w] >> 8);
+		*p++ = (uint8_t)(words[w] >> 16);
+		*p++ = (uint8_t)(words[w] >> 24);
+	}
+	*p++ = (uint8_t)duty->duty_permille;
+	*p++ = (uint8_t)(duty->duty_permille >> 8);
+
+	return adxlFrameEncode(ADXL_FRAME_DUTY, payload, ADXL_DUTY_PAYLOAD, out);
+}
+
+/**
+ * @brief  Unpacks an ADXL_FRAME_DUTY payload.
+ * @param  payload: Payload bytes
+ * @param  len: Payload length
+ * @param  duty: Destination
+ * @return 1 on success, 0 if the payload is malformed
+ */
+uint8_t adxlDutyParse(const uint8_t *payload, uint8_t len, ADXL_DutyType *duty){
+	const uint8_t *p = payload;
+	uint32_t words[3];
+
+	if(len != ADXL_DUTY_PAYLOAD) return 0;
+
+	for(uint8_t w = 0; w < 3; w++, p += 4){
+		words[w] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	}
+	duty->awake_us_per_s = words[0];
+	duty->wakeups_per_s = words[1];
+	duty->us_per_wakeup = words[2];
+	duty->duty_permille = (uint16_t)(p[0] | (p[1] << 8));
+	return 1;
+}
+
+/* --------------------------------------------------
+ * Decoding
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Resets a stream decoder.
+ * @param  dec: Pointer to ADXL_FrameDecoderType structure
+ * @return None
+ */
+void adxlFrameDecoderInit(ADXL_FrameDecoderType *dec){
+	memset(dec, 0, sizeof(*dec));
+}
+
+/**
+ * @brief  Feeds received bytes and reports every complete, valid frame.
+ * @param  dec: Pointer to ADXL_FrameDecoderType structure
+ * @param  data: Received bytes (any split across calls is fine)
+ * @param  len: Number of bytes
+ * @param  handler: Called once per valid frame; payload points into the decoder
+ * @param  ctx: Passed to handler
+ * @return None
+ */
+void adxlFrameDecode(ADXL_FrameDecoderType *dec, const uint8_t *data, uint32_t len,
+		ADXL_FrameHandlerType handler, void *ctx){
+	do{
+		uint32_t n = sizeof(dec->buf) - dec->pos;
+		if(n > len) n = len;
+		memcpy(&dec->buf[dec->pos], data, n);
+		dec->pos += n;
+		data += n;
+		len -= n;
+
+		uint16_t start = 0;
+		while(start < dec->pos){
+			const uint8_t *sync = memchr(&dec->buf[start], ADXL_FRAME_SYNC0, dec->pos - start);
+			if(sync == NULL){
+				dec->skipped += dec->pos - start;
+				start = dec->pos;
+				break;
+			}
+			dec->skipped += (uint32_t)(sync - &dec->buf[start]);
+			start = (uint16_t)(sync - dec->buf);
+
+			if(dec->pos - start < 4) break;                      //*Header incomplete
+			if(dec->buf[start + 1] != ADXL_FRAME_SYNC1){
+				dec->skipped++;
+				start++;
+				continue;
+			}
+
+			uint16_t total = (uint16_t)(dec->buf[start + 3] + ADXL_FRAME_OVERHEAD);
+			if(dec->pos - start < total) break;                  //*Payload incomplete
+
+			const uint8_t *f = &dec->buf[start];
+			uint16_t crc = (uint16_t)(f[total - 2] | (f[total - 1] << 8));
+			if(adxlFrameCrc(&f[2], (uint16_t)(total - 4U)) != crc){
+				dec->crc_errors++;
+				dec->skipped++;
+				start++;                                         //*Resync after the false sync byte
+				continue;
+			}
+
+			dec->frames++;
+			handler(ctx, f[2], &f[4], f[3]);
+			start += total;
+		}
+
+		memmove(dec->buf, &dec->buf[start], dec->pos - start);
+		dec->pos -= start;
+	}while(len > 0);
+}
@@ -0,0 +1,91 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_frame.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Serial framing of sample blocks (adxl345_frame.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - MCU side: adxlFrameEncodeBlock() packs a block for UART/USB transmission
+ *   - Host side: adxlFrameDecode() consumes whatever read() returned and
+ *     reports every complete frame; it resynchronizes after noise or CRC errors
+ *
+ *   Frame: | 0xA5 | 0x5A | type | len | payload (len bytes) | crc16 (LE) |
+ *   CRC-16/CCITT-FALSE over type, len and payload.
+ *
+ *   ADXL_FRAME_BLOCK payload: seq (u32 LE), config_seq (u16 LE), data_format,
+ *                             bw_rate, axes_off, then count x {x, y, z} (s16 LE)
+ *   ADXL_FRAME_HEALTH payload: ADXL_HealthStatusType (LE): flags, latched,
+ *                              stuck_axes, saturated_axes, noise[3], floor[3],
+ *                              baseline[3], max_run[3], windows (u32),
+ *                              devid_checks, devid_failures
+ *   ADXL_FRAME_DUTY payload: ADXL_DutyType (LE): awake_us_per_s, wakeups_per_s,
+ *                            us_per_wakeup (u32), duty_permille (u16)
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_FRAME_H_
+#define INC_ADXL345_FRAME_H_
+
+#include "adxl345_types.h"
+
+/* --------------------------------------------------
+ * 1. Frame setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_FRAME_SYNC0 0xA5
+#define ADXL_FRAME_SYNC1 0x5A
+#define ADXL_FRAME_OVERHEAD 6                       //*sync(2) + type + len + crc(2)
+#define ADXL_FRAME_MAX_PAYLOAD 255
+#define ADXL_FRAME_MAX (ADXL_FRAME_OVERHEAD + ADXL_FRAME_MAX_PAYLOAD)
+
+#define ADXL_FRAME_BLOCK 0x01                       //*Sample block
+#define ADXL_FRAME_HEALTH 0x02                      //*Health summary (adxl345_health.c)
+#define ADXL_FRAME_DUTY 0x03                        //*MCU duty cycle (adxl345_idle.c)
+
+#define ADXL_FRAME_BLOCK_HEADER 9                   //*Block payload bytes before the samples
+#define ADXL_HEALTH_PAYLOAD 36                      //*ADXL_FRAME_HEALTH payload: 4 bytes, 12 x u16, u32, 2 x u16
+#define ADXL_DUTY_PAYLOAD 14                        //*ADXL_FRAME_DUTY payload: 3 x u32, u16
+
+_Static_assert(ADXL_FRAME_BLOCK_HEADER + ADXL_BLOCK_SAMPLES * 6 <= ADXL_FRAME_MAX_PAYLOAD, "a full block must fit one frame");
+
+/* --------------------------------------------------
+ * 2. Frame Typedef
+ * --------------------------------------------------*/
+
+/** Called for every valid frame found by adxlFrameDecode() */
+typedef void (*ADXL_FrameHandlerType)(void *ctx, uint8_t type, const uint8_t *payload, uint8_t len);
+
+typedef struct{
+	uint8_t buf[2 * ADXL_FRAME_MAX];                  //*Room for one partial and one full frame
+	uint16_t pos;
+	uint32_t frames;
+	uint32_t crc_errors;
+	uint32_t skipped;                               //*Bytes discarded while resynchronizing
+} ADXL_FrameDecoderType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+uint16_t adxlFrameCrc(const uint8_t *data, uint16_t len);
+uint16_t adxlFrameEncode(uint8_t type, const uint8_t *payload, uint8_t len, uint8_t *out);
+uint16_t adxlFrameEncodeBlock(const ADXL_BlockType *block, uint8_t *out);
+uint8_t adxlFrameParseBlock(const uint8_t *payload, uint8_t len, ADXL_BlockType *block);
+uint16_t adxlHealthEncode(const ADXL_HealthStatusType *status, uint8_t *out);
+uint8_t adxlHealthParse(const uint8_t *payload, uint8_t len, ADXL_HealthStatusType *status);
+uint16_t adxlDutyEncode(const ADXL_DutyType *duty, uint8_t *out);
+uint8_t adxlDutyParse(const uint8_t *payload, uint8_t len, ADXL_DutyType *duty);
+
+void adxlFrameDecoderInit(ADXL_FrameDecoderType *dec);
+void adxlFrameDecode(ADXL_FrameDecoderType *dec, const uint8_t *data, uint32_t len,
+		ADXL_FrameHandlerType handler, void *ctx);
+
+#endif /* INC_ADXL345_FRAME_H_ */
@@ -0,0 +1,163 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_glitch.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Glitch rejection: running median and spike replacement (adxl345_glitch.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Samples are AoS (x, y, z); each axis is walked with a stride of 3.
+ *     The loops have no data-dependent branches, so the cost per sample is
+ *     fixed (a few ALU operations; the compiler emits SEL / IT or cmov).
+ *   - Median of 5: median3(e, max(min(a,b), min(c,d)), min(max(a,b), max(c,d))).
+ *   - Values are int16, so the differences below never overflow int32.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_glitch.h"
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+ADXL_GlitchType adxlGlitch = { .mode = ADXL_GLITCH_SPIKE, .slope = 400 };
+
+/* --------------------------------------------------
+ * Branchless helpers
+ * --------------------------------------------------*/
+
+static inline int32_t min32(int32_t a, int32_t b){
+	int32_t d = a - b;
+	return b + (d & (d >> 31));
+}
+
+static inline int32_t max32(int32_t a, int32_t b){
+	int32_t d = a - b;
+	return a - (d & (d >> 31));
+}
+
+static inline int32_t abs32(int32_t v){
+	int32_t m = v >> 31;
+	return (v ^ m) - m;
+}
+
+static inline int32_t median3(int32_t a, int32_t b, int32_t c){
+	return max32(min32(a, b), min32(max32(a, b), c));
+}
+
+/* --------------------------------------------------
+ * Glitch
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Initializes the glitch filter.
+ * @param  glitch: Pointer to ADXL_GlitchType structure
+ * @param  mode: ADXL_GLITCH_xxx
+ * @param  slope: Largest legitimate change between samples (block units, mg after Convert);
+ *                the median modes count a replacement only when it moves the sample further
+ * @return None
+ */
+void adxlGlitchInit(ADXL_GlitchType *glitch, uint8_t mode, int32_t slope){
+	*glitch = (ADXL_GlitchType){0};
+	glitch->mode = mode;
+	glitch->slope = slope;
+}
+
+/**
+ * @brief  Filters a block in place.
+ * @param  glitch: Pointer to ADXL_GlitchType structure
+ * @param  block: Pipeline block
+ * @return None
+ * @note   Output i is the filtered input i-1 (i-2 for MEDIAN5).
+ */
+void adxlGlitchBlock(ADXL_GlitchType *glitch, ADXL_BlockType *block){
+	const int32_t t = glitch->slope;
+
+	if(glitch->mode == ADXL_GLITCH_OFF || block->count == 0) return;
+
+	if(!glitch->primed || glitch->config_seq != block->config_seq){
+		const int16_t *v = &block->samples[0].x;
+		for(uint8_t a = 0; a < 3; a++){
+			for(uint8_t k = 0; k < 4; k++) glitch->hist[a][k] = v[a];
+		}
+		glitch->config_seq = block->config_seq;
+		glitch->primed = 1;
+	}
+
+	for(uint8_t a = 0; a < 3; a++){
+		if(block->axes_off & (ADXL_AXIS_X >> a)) continue;
+
+		int16_t *v = &block->samples[0].x + a;
+		int32_t *h = glitch->hist[a];
+		int32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3];
+		uint32_t rejected = 0;
+
+		switch(glitch->mode){
+			case ADXL_GLITCH_MEDIAN3:
+				for(uint16_t i = 0; i < block->count; i++, v += 3){
+					int32_t x = *v;
+					int32_t m = median3(h1, h0, x);
+					rejected += (uint32_t)(t - abs32(m - h0)) >> 31;
+					*v = (int16_t)m;
+					h1 = h0;
+					h0 = x;
+				}
+				break;
+
+			case ADXL_GLITCH_MEDIAN5:
+				for(uint16_t i = 0; i < block->count; i++, v += 3){
+					int32_t x = *v;
+					int32_t f = max32(min32(h3, h2), min32(h0, x));
+					int32_t g = min32(max32(h3, h2), max32(h0, x));
+					int32_t m = median3(h1, f, g);
+					rejected += (uint32_t)(t - abs32(m - h1)) >> 31;
+					*v = (int16_t)m;
+					h3 = h2;
+					h2 = h1;
+					h1 = h0;
+					h0 = x;
+				}
+				break;
+
+			case ADXL_GLITCH_SPIKE:
+				for(uint16_t i = 0; i < block->count; i++, v += 3){
+					int32_t x = *v;
+					int32_t d1 = h0 - h1;                  //*Jump into the candidate
+					int32_t d2 = h0 - x;                   //*Jump out of it
+					uint32_t spike = ((uint32_t)(t - abs32(d1)) >> 31) &
+							((uint32_t)(t - abs32(d2)) >> 31) &
+							(~(uint32_t)(d1 ^ d2) >> 31);   //*Same direction
+					int32_t m = h0 + (((h1 + x) / 2 - h0) & -(int32_t)spike);
+					rejected += spike;
+					*v = (int16_t)m;
+					h1 = m;                                //*Later decisions see the repaired value
+					h0 = x;
+				}
+				break;
+
+			default:
+				return;
+		}
+
+		h[0] = h0;
+		h[1] = h1;
+		h[2] = h2;
+		h[3] = h3;
+		glitch->rejected[a] += rejected;
+	}
+	glitch->samples += block->count;
+}
+
+/**
+ * @brief  Pipeline stage: filters the block with the selected device's glitch
+ *         state (ADXL_DeviceType.glitch), or adxlGlitch if it has none.
+ * @param  block: Pipeline block
+ * @return None
+ */
+void adxlStageGlitch(ADXL_BlockType *block){
+	ADXL_DeviceType *dev = adxlSelected();
+
+	adxlGlitchBlock((dev != NULL && dev->glitch != NULL) ? dev->glitch : &adxlGlitch, block);
+}
@@ -0,0 +1,74 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_glitch.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Glitch rejection: running median and spike replacement (adxl345_glitch.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - ADXL_GLITCH_MEDIAN3 / MEDIAN5: running median over 3 / 5 samples
+ *   - ADXL_GLITCH_SPIKE: a sample that leaves both neighbours by more than
+ *     the slope limit, in the same direction, is replaced by their mean;
+ *     steps and fast but smooth motion pass unchanged
+ *   - Branchless inner loops (min/max and flags by arithmetic), one pass per
+ *     axis over the block; disabled axes are skipped
+ *   - Latency: 1 sample (MEDIAN3, SPIKE) or 2 samples (MEDIAN5); the history
+ *     carries across blocks and is re-primed when the configuration changes
+ *   - Counters: samples seen and samples replaced per axis (median modes:
+ *     replaced by more than the slope limit, so noise is not counted)
+ *
+ *  @usage
+ *   adxlGlitchInit(&adxlGlitch, ADXL_GLITCH_SPIKE, 400);    // 400 mg/sample slope limit
+ *   #define STAGES(X, a) X(a, adxlStageAcquire, 1) X(a, adxlStageConvert, 1) \
+ *                        X(a, adxlStageGlitch, 1) X(a, adxlStageFilter, 1)
+ *   adxlGlitch.rejected[2] is the number of Z samples replaced
+ *   several devices: dev[i].glitch = &glitch[i];  (adxlStageGlitch() follows adxlSelect())
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_GLITCH_H_
+#define INC_ADXL345_GLITCH_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Glitch setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_GLITCH_OFF 0
+#define ADXL_GLITCH_MEDIAN3 1
+#define ADXL_GLITCH_MEDIAN5 2
+#define ADXL_GLITCH_SPIKE 3
+
+/* --------------------------------------------------
+ * 2. Glitch Typedef
+ * --------------------------------------------------*/
+
+typedef struct ADXL_Glitch{
+	uint8_t mode;                    //*ADXL_GLITCH_xxx
+	uint8_t primed;
+	uint16_t config_seq;             //*Configuration the history belongs to
+	int32_t slope;                   //*Largest legitimate change per sample
+	int32_t hist[3][4];              //*Per axis: previous inputs, newest first
+	uint32_t samples;                //*Samples processed (per axis)
+	uint32_t rejected[3];            //*Samples replaced per axis
+} ADXL_GlitchType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlGlitchInit(ADXL_GlitchType *glitch, uint8_t mode, int32_t slope);
+void adxlGlitchBlock(ADXL_GlitchType *glitch, ADXL_BlockType *block);
+
+void adxlStageGlitch(ADXL_BlockType *block);
+extern ADXL_GlitchType adxlGlitch;
+
+#endif /* INC_ADXL345_GLITCH_H_ */
@@ -0,0 +1,274 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_health.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Sensor health monitor (adxl345_health.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - The floor is the minimum over several windows so that vibration does
+ *     not read as a noise shift; a dead or stuck axis drives it towards 0.
+ *   - Full scale depends on DATA_FORMAT: +-512 LSB in 10-bit mode, +-(512 << range)
+ *     in full resolution (right-justified data).
+ *   - A reconfiguration (config_seq) restarts the window. A learned baseline
+ *     is relearned only if range or resolution changed (the noise in LSB
+ *     depends on them); a baseline set with adxlHealthSetBaseline() is kept.
+ *   - The ADXL_FRAME_HEALTH encoder/parser live in adxl345_frame.c, so the
+ *     host side can read health frames without the driver.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_health.h"
+#include <string.h>
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+ADXL_HealthType adxlHealth = ADXL_HEALTH_DEFAULT;
+
+/**
+ * @brief  Integer square root.
+ */
+static uint32_t isqrt64(uint64_t v){
+	uint64_t r = 0, bit = 1ULL << 62;
+
+	while(bit > v) bit >>= 2;
+	while(bit != 0){
+		if(v >= r + bit){
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else{
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)r;
+}
+
+/**
+ * @brief  Restarts the window and the noise floor (baseline kept).
+ */
+static void healthRestart(ADXL_HealthType *health){
+	health->n = 0;
+	health->floor_count = 0;
+	for(uint8_t a = 0; a < 3; a++){
+		health->sum[a] = 0;
+		health->sumsq[a] = 0;
+		health->run[a] = 0;
+		health->max_run[a] = 0;
+		health->saturated[a] = 0;
+		health->floor_min[a] = UINT16_MAX;
+	}
+}
+
+/**
+ * @brief  Closes a window: noise, stuck and saturation flags, noise floor.
+ */
+static void healthWindow(ADXL_HealthType *health, uint8_t axes_off){
+	ADXL_HealthStatusType *st = &health->status;
+	const int64_t n = health->n;
+	uint8_t flags = st->flags & ADXL_HEALTH_DEVID;
+
+	st->stuck_axes = 0;
+	st->saturated_axes = 0;
+
+	for(uint8_t a = 0; a < 3; a++){
+		uint8_t bit = (uint8_t)(ADXL_AXIS_X >> a);
+		if(axes_off & bit) continue;
+
+		/* var * 256 = (n * sumsq - sum^2) * 256 / n^2 -> std in Q4 */
+		int64_t num = n * health->sumsq[a] - (int64_t)health->sum[a] * health->sum[a];
+		uint32_t std = isqrt64((uint64_t)((num > 0) ? num : 0) * 256U / (uint64_t)(n * n));
+		st->noise[a] = (uint16_t)((std > UINT16_MAX) ? UINT16_MAX : std);
+
+		if(health->run[a] > health->max_run[a]) health->max_run[a] = health->run[a];
+		st->max_run[a] = health->max_run[a];
+		if(health->max_run[a] >= health->stuck_run) st->stuck_axes |= bit;
+		if(health->saturated[a] != 0) st->saturated_axes |= bit;
+		if(st->noise[a] < health->floor_min[a]) health->floor_min[a] = st->noise[a];
+
+		health->sum[a] = 0;
+		health->sumsq[a] = 0;
+		health->max_run[a] = 0;               //*A run in progress carries on into the next window
+		health->saturated[a] = 0;
+	}
+	health->n = 0;
+	st->windows++;
+
+	if(st->stuck_axes) flags |= ADXL_HEALTH_STUCK;
+	if(st->saturated_axes) flags |= ADXL_HEALTH_SATURATED;
+
+	/* Noise floor period */
+	if(++health->floor_count >= health->floor_windows){
+		for(uint8_t a = 0; a < 3; a++){
+			if(health->floor_min[a] == UINT16_MAX) continue;
+			st->floor[a] = health->floor_min[a];
+			health->floor_min[a] = UINT16_MAX;
+
+			if(st->baseline[a] == 0){
+				st->baseline[a] = (st->floor[a] != 0) ? st->floor[a] : 1;
+				continue;
+			}
+			/* Half an LSB of slack keeps quantization from tripping a quiet axis */
+			if(st->floor[a] > st->baseline[a] * health->noise_ratio + 8) flags |= ADXL_HEALTH_NOISE_HIGH;
+			if(st->floor[a] * health->noise_ratio + 8 < st->baseline[a]) flags |= ADXL_HEALTH_NOISE_LOW;
+		}
+		health->floor_count = 0;
+	}
+	else{
+		flags |= st->flags & (ADXL_HEALTH_NOISE_HIGH | ADXL_HEALTH_NOISE_LOW);
+	}
+
+	st->flags = flags;
+	st->latched |= flags;
+}
+
+/**
+ * @brief  Initializes a health monitor.
+ * @param  health: Pointer to ADXL_HealthType structure
+ * @param  window: Samples per window (e.g. ODR x 2.56 s)
+ * @param  stuck_run: Identical samples that count as stuck (depends on resolution)
+ * @param  floor_windows: Windows per noise-floor period
+ * @param  noise_ratio: Allowed noise floor shift as a standard deviation ratio (>= 2)
+ * @param  devid_every_ms: DEVID check interval (0: off)
+ * @return None
+ */
+void adxlHealthInit(ADXL_HealthType *health, uint16_t window, uint16_t stuck_run, uint8_t floor_windows, uint8_t noise_ratio, uint32_t devid_every_ms){
+	*health = (ADXL_HealthType){0};
+	health->window = (window != 0) ? window : 1;
+	health->stuck_run = stuck_run;
+	health->floor_windows = (floor_windows != 0) ? floor_windows : 1;
+	health->noise_ratio = noise_ratio;
+	health->devid_every_ms = devid_every_ms;
+}
+
+/**
+ * @brief  Adds a raw block to the monitor.
+ * @param  health: Pointer to ADXL_HealthType structure
+ * @param  block: Raw samples (LSB), as drained
+ * @return None
+ */
+void adxlHealthBlock(ADXL_HealthType *health, const ADXL_BlockType *block){
+	int16_t limit = (int16_t)((block->data_format & FULL_RESOLUTION) ? (512 << (block->data_format & 0x03)) : 512);
+	uint16_t i = 0;
+
+	if(block->count == 0) return;
+
+	if(!health->primed || health->config_seq != block->config_seq){
+		/* A learned baseline is in LSB: relearn it only if range/resolution changed */
+		if(health->primed && !health->baseline_set &&
+				((health->data_format ^ block->data_format) & (FULL_RESOLUTION | 0x03))){
+			memset(health->status.baseline, 0, sizeof(health->status.baseline));
+		}
+		healthRestart(health);
+		for(uint8_t a = 0; a < 3; a++) health->last[a] = (&block->samples[0].x)[a];
+		health->config_seq = block->config_seq;
+		health->data_format = block->data_format;
+		health->primed = 1;
+	}
+
+	while(i < block->count){
+		uint16_t take = (uint16_t)(health->window - health->n);
+		if(take > block->count - i) take = (uint16_t)(block->count - i);
+
+		for(uint8_t a = 0; a < 3; a++){
+			if(block->axes_off & (ADXL_AXIS_X >> a)) continue;
+
+			const int16_t *v = &block->samples[i].x + a;
+			int32_t sum = 0;
+			int64_t sumsq = 0;
+			int16_t last = health->last[a];
+			uint16_t run = health->run[a], max_run = health->max_run[a], sat = 0;
+
+			for(uint16_t k = 0; k < take; k++, v += 3){
+				int32_t x = *v;
+				sum += x;
+				sumsq += x * x;
+				if(x == last){
+					run++;
+				}
+				else{
+					if(run > max_run) max_run = run;
+					run = 1;
+					last = (int16_t)x;
+				}
+				sat += (uint16_t)(x >= limit - 1 || x <= -limit);
+			}
+
+			health->sum[a] += sum;
+			health->sumsq[a] += sumsq;
+			health->last[a] = last;
+			health->run[a] = run;
+			health->max_run[a] = max_run;
+			health->saturated[a] += sat;
+		}
+
+		health->n += take;
+		i += take;
+		if(health->n >= health->window) healthWindow(health, block->axes_off);
+	}
+}
+
+/**
+ * @brief  Verifies DEVID when the interval has elapsed (main loop).
+ * @param  health: Pointer to ADXL_HealthType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return Current ADXL_HEALTH_xxx flags
+ * @note   Skipped while a non-blocking transfer owns the bus (adxlBusy()).
+ */
+uint8_t adxlHealthPoll(ADXL_HealthType *health, uint32_t now_ms){
+	ADXL_HealthStatusType *st = &health->status;
+
+	if(health->devid_every_ms == 0 || now_ms - health->devid_ms < health->devid_every_ms) return st->flags;
+	if(adxlBusy()) return st->flags;
+
+	health->devid_ms = now_ms;
+	st->devid_checks++;
+	if(checkDevId() == ADXL_OK){
+		st->flags &= (uint8_t)~ADXL_HEALTH_DEVID;
+	}
+	else{
+		st->devid_failures++;
+		st->flags |= ADXL_HEALTH_DEVID;
+		st->latched |= ADXL_HEALTH_DEVID;
+	}
+	return st->flags;
+}
+
+/**
+ * @brief  Sets the reference noise floor (e.g. measured at commissioning).
+ * @param  health: Pointer to ADXL_HealthType structure
+ * @param  baseline: Standard deviation per axis, LSB in Q4 (0: learn)
+ * @return None
+ * @note   A set baseline survives reconfigurations; set it for the range and
+ *         resolution the sensor runs with.
+ */
+void adxlHealthSetBaseline(ADXL_HealthType *health, const uint16_t baseline[3]){
+	memcpy(health->status.baseline, baseline, sizeof(health->status.baseline));
+	health->baseline_set = (baseline[0] | baseline[1] | baseline[2]) != 0;
+}
+
+/**
+ * @brief  Clears the latched flags.
+ * @param  health: Pointer to ADXL_HealthType structure
+ * @return None
+ */
+void adxlHealthClear(ADXL_HealthType *health){
+	health->status.latched = health->status.flags;
+}
+
+/**
+ * @brief  Pipeline stage: feeds the raw block into the selected device's health
+ *         state (ADXL_DeviceType.health), or adxlHealth if it has none.
+ * @param  block: Pipeline block (raw, before Convert)
+ * @return None
+ */
+void adxlStageHealth(ADXL_BlockType *block){
+	ADXL_DeviceType *dev = adxlSelected();
+
+	adxlHealthBlock((dev != NULL && dev->health != NULL) ? dev->health : &adxlHealth, block);
+}
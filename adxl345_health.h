@@ -0,0 +1,95 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_health.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Sensor health monitor (adxl345_health.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Per axis over a window of samples: variance (noise), longest run of
+ *     identical samples (stuck output) and samples at full scale (saturation)
+ *   - Noise floor: the quietest window of a floor period; compared with a
+ *     baseline learned from the first period (or set at commissioning)
+ *   - DEVID verified every devid_every_ms from the main loop (checkDevId(),
+ *     the silent form of adxlTest())
+ *   - Runs on raw blocks (right after adxlStageAcquire): a few adds and
+ *     compares per sample, no bus access
+ *   - ADXL_HealthStatusType (adxl345_types.h) is the compact result;
+ *     adxlHealthEncode() (adxl345_frame.c) sends it as an ADXL_FRAME_HEALTH
+ *     frame next to the sample frames
+ *
+ *  @usage
+ *   #define STAGES(X, a) X(a, adxlStageAcquire, 1) X(a, adxlStageHealth, 1) \
+ *                        X(a, adxlStageConvert, 1) ...
+ *   main loop:  adxlHealthPoll(&adxlHealth, HAL_GetTick());
+ *               if(adxlHealth.status.flags) alarm();
+ *   every minute: n = adxlHealthEncode(&adxlHealth.status, frame);  uart_send(frame, n);
+ *   several devices: dev[i].health = &health[i];  (adxlStageHealth() follows adxlSelect();
+ *               adxlSelect(&dev[i]) before adxlHealthPoll(&health[i], ...))
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_HEALTH_H_
+#define INC_ADXL345_HEALTH_H_
+
+#include "adxl345.h"
+#include "adxl345_frame.h"
+
+/* --------------------------------------------------
+ * 1. Health setting value define
+ * --------------------------------------------------*/
+
+/** 256-sample windows, stuck after 128 equal samples, floor over 16 windows, x2 noise shift, DEVID every 10 s */
+#define ADXL_HEALTH_DEFAULT { .window = 256, .stuck_run = 128, .floor_windows = 16, \
+	.noise_ratio = 2, .devid_every_ms = 10000 }
+
+/* --------------------------------------------------
+ * 2. Health Typedef
+ * --------------------------------------------------*/
+
+typedef struct ADXL_Health{
+	uint16_t window;                 //*Samples per window
+	uint16_t stuck_run;              //*Identical samples that count as stuck
+	uint8_t floor_windows;           //*Windows per noise-floor period
+	uint8_t noise_ratio;             //*Allowed floor shift (standard deviation ratio)
+	uint32_t devid_every_ms;         //*0: no DEVID checks
+
+	uint16_t config_seq;
+	uint8_t data_format;             //*Range/resolution of the current windows
+	uint8_t baseline_set;            //*1: baseline from adxlHealthSetBaseline(), never relearned
+	uint8_t primed;
+	uint8_t floor_count;
+	uint16_t n;
+	int32_t sum[3];
+	int64_t sumsq[3];
+	int16_t last[3];
+	uint16_t run[3];
+	uint16_t max_run[3];
+	uint16_t saturated[3];
+	uint16_t floor_min[3];
+	uint32_t devid_ms;
+
+	ADXL_HealthStatusType status;
+} ADXL_HealthType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlHealthInit(ADXL_HealthType *health, uint16_t window, uint16_t stuck_run, uint8_t floor_windows, uint8_t noise_ratio, uint32_t devid_every_ms);
+void adxlHealthBlock(ADXL_HealthType *health, const ADXL_BlockType *block);
+uint8_t adxlHealthPoll(ADXL_HealthType *health, uint32_t now_ms);
+void adxlHealthSetBaseline(ADXL_HealthType *health, const uint16_t baseline[3]);
+void adxlHealthClear(ADXL_HealthType *health);
+
+void adxlStageHealth(ADXL_BlockType *block);
+extern ADXL_HealthType adxlHealth;
+
+#endif /* INC_ADXL345_HEALTH_H_ */
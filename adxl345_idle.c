@@ -0,0 +1,159 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_idle.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       MCU sleep between interrupts with duty-cycle accounting (adxl345_idle.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - MCU time base: DWT cycle counter (enabled here), converted with
+ *     SystemCoreClock. Elapsed cycles are accumulated, so the 32-bit wrap
+ *     does not matter as long as adxlIdleEnter() runs more often than it.
+ *   - Linux time base: simulated time (adxlSim.now_us); awake time is the
+ *     bus time spent between two sleeps.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_idle.h"
+
+#if defined(ADXL_USE_LINUX)
+#include "adxl345_sim.h"
+#endif
+
+/**
+ * @brief  Microseconds since the previous call.
+ */
+static uint32_t idleElapsedUs(ADXL_IdleType *idle){
+#if defined(ADXL_USE_LINUX)
+	uint64_t now = adxlSim.now_us;
+	uint32_t us = (uint32_t)(now - idle->last_us);
+
+	idle->last_us = now;
+	return us;
+#else
+	uint32_t cycles = DWT->CYCCNT;
+	uint32_t delta = cycles - idle->last_cycles + idle->cycles_rem;
+
+	idle->last_cycles = cycles;
+	idle->cycles_rem = delta % idle->ticks_per_us;
+	return delta / idle->ticks_per_us;
+#endif
+}
+
+/**
+ * @brief  Sleeps until the next interrupt.
+ */
+static void idleSleep(void){
+#if defined(ADXL_USE_LINUX)
+	const uint8_t *shadow = getShadow();
+	uint8_t enabled = shadow[INT_ENABLE - ADXL_SHADOW_FIRST];
+
+	for(uint32_t t = 0; t < ADXL_IDLE_SIM_MAX_US; t += ADXL_IDLE_SIM_STEP_US){
+		adxlSimAdvance(ADXL_IDLE_SIM_STEP_US);
+		if(adxlSim.reg[INT_SOURCE] & enabled) break;
+	}
+#else
+	HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+#endif
+}
+
+/**
+ * @brief  Latches the window statistics and starts a new window.
+ */
+static void idleLatch(ADXL_IdleType *idle){
+	uint32_t elapsed = idle->window_elapsed_us;
+
+	idle->last.awake_us_per_s = (uint32_t)((uint64_t)idle->awake_us * 1000000U / elapsed);
+	idle->last.wakeups_per_s = (uint32_t)((uint64_t)idle->wakeups * 1000000U / elapsed);
+	idle->last.us_per_wakeup = (idle->wakeups != 0) ? idle->awake_us / idle->wakeups : idle->awake_us;
+	idle->last.duty_permille = (uint16_t)((uint64_t)idle->awake_us * 1000U / elapsed);
+
+	idle->window_elapsed_us = 0;
+	idle->awake_us = 0;
+	idle->asleep_us = 0;
+	idle->wakeups = 0;
+}
+
+/**
+ * @brief  Initializes the idle hook and its accounting.
+ * @param  idle: Pointer to ADXL_IdleType structure
+ * @param  window_us: Accounting window (0: ADXL_IDLE_WINDOW_US)
+ * @return None
+ */
+void adxlIdleInit(ADXL_IdleType *idle, uint32_t window_us){
+	*idle = (ADXL_IdleType){0};
+	idle->window_us = (window_us != 0) ? window_us : ADXL_IDLE_WINDOW_US;
+
+#if defined(ADXL_USE_LINUX)
+	idle->last_us = adxlSim.now_us;
+#else
+	idle->ticks_per_us = SystemCoreClock / 1000000U;
+	if(idle->ticks_per_us == 0) idle->ticks_per_us = 1;   //*Below 1 MHz: times read high, no division by zero
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	idle->last_cycles = DWT->CYCCNT;
+#endif
+}
+
+/**
+ * @brief  Marks work pending (call from interrupt callbacks that queue work).
+ * @param  idle: Pointer to ADXL_IdleType structure
+ * @return None
+ */
+void adxlIdleKick(ADXL_IdleType *idle){
+	idle->pending = 1;
+}
+
+/**
+ * @brief  Main-loop idle hook: sleeps if nothing is pending.
+ * @param  idle: Pointer to ADXL_IdleType structure
+ * @return 1 if the MCU slept, 0 if work was pending (the loop should run again)
+ */
+uint8_t adxlIdleEnter(ADXL_IdleType *idle){
+	uint32_t awake, asleep;
+
+#if !defined(ADXL_USE_LINUX)
+	__disable_irq();
+#endif
+	/* A DMA/IT transfer in flight is no reason to stay awake: its completion
+	 * interrupt wakes the core and the callback kicks the loop */
+	if(idle->pending){
+		idle->pending = 0;
+		idle->skipped++;
+#if !defined(ADXL_USE_LINUX)
+		__enable_irq();
+#endif
+		return 0;
+	}
+
+	awake = idleElapsedUs(idle);
+	idleSleep();                                 //*Wakes on any pending interrupt, even masked
+	asleep = idleElapsedUs(idle);
+#if !defined(ADXL_USE_LINUX)
+	__enable_irq();                              //*The waking interrupt is serviced here
+#endif
+
+	idle->awake_us += awake;
+	idle->asleep_us += asleep;
+	idle->wakeups++;
+	idle->total_awake_us += awake;
+	idle->total_asleep_us += asleep;
+	idle->total_wakeups++;
+
+	idle->window_elapsed_us += awake + asleep;
+	if(idle->window_elapsed_us >= idle->window_us) idleLatch(idle);
+	return 1;
+}
+
+/**
+ * @brief  Returns the duty-cycle figures of the last complete window.
+ * @param  idle: Pointer to ADXL_IdleType structure
+ * @param  duty: Pointer to ADXL_DutyType structure
+ * @return None
+ */
+void adxlIdleStats(const ADXL_IdleType *idle, ADXL_DutyType *duty){
+	*duty = idle->last;
+}
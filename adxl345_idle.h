@@ -0,0 +1,93 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_idle.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       MCU sleep between interrupts with duty-cycle accounting (adxl345_idle.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - adxlIdleEnter() is the main-loop idle hook: it sleeps (WFI) unless an
+ *     interrupt marked work pending with adxlIdleKick(); a driver DMA/IT
+ *     transfer in flight does not keep the core awake (its completion wakes it)
+ *   - The check and the WFI run with interrupts masked: an interrupt arriving
+ *     in between still wakes the core, so no wake-up is lost
+ *   - Awake and asleep time are measured around every sleep and latched per
+ *     window (default 1 s): awake time per second, wake-ups per second, time
+ *     per wake-up and duty cycle
+ *   - adxlDutyEncode() (adxl345_frame.c) sends the latched figures as an
+ *     ADXL_FRAME_DUTY frame next to the health frames; adxl345_ingest.c keeps
+ *     the last one per stream
+ *   - Linux (-DADXL_USE_LINUX): the MCU is emulated on the simulator; sleeping
+ *     advances simulated time until an enabled interrupt is raised
+ *
+ *  @usage
+ *   ADXL_IdleType idle;
+ *   adxlIdleInit(&idle, 1000000);
+ *   EXTI / DMA callbacks:  adxlIdleKick(&idle);
+ *   while(1){ process(); adxlIdleEnter(&idle); }
+ *   adxlIdleStats(&idle, &duty);
+ *   len = adxlDutyEncode(&duty, frame);   uart_send(frame, len);
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_IDLE_H_
+#define INC_ADXL345_IDLE_H_
+
+#include "adxl345.h"
+#include "adxl345_frame.h"
+
+/* --------------------------------------------------
+ * 1. Idle setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_IDLE_WINDOW_US 1000000  //*Default accounting window
+
+#define ADXL_IDLE_SIM_STEP_US 100    //*Simulated sleep resolution
+#define ADXL_IDLE_SIM_MAX_US 1000000 //*Longest simulated sleep (no interrupt enabled)
+
+/* --------------------------------------------------
+ * 2. Idle Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	volatile uint8_t pending;        //*Set by adxlIdleKick()
+	uint32_t window_us;
+
+	/* Clock */
+	uint32_t last_cycles;
+	uint32_t cycles_rem;
+	uint32_t ticks_per_us;
+	uint64_t last_us;
+
+	/* Current window */
+	uint32_t window_elapsed_us;
+	uint32_t awake_us;
+	uint32_t asleep_us;
+	uint32_t wakeups;
+
+	/* Totals */
+	uint64_t total_awake_us;
+	uint64_t total_asleep_us;
+	uint32_t total_wakeups;
+	uint32_t skipped;                //*Idle calls that found work pending
+
+	ADXL_DutyType last;              //*Latched at the end of each window
+} ADXL_IdleType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlIdleInit(ADXL_IdleType *idle, uint32_t window_us);
+void adxlIdleKick(ADXL_IdleType *idle);
+uint8_t adxlIdleEnter(ADXL_IdleType *idle);
+void adxlIdleStats(const ADXL_IdleType *idle, ADXL_DutyType *duty);
+
+#endif /* INC_ADXL345_IDLE_H_ */
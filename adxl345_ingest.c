@@ -0,0 +1,283 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_ingest.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Single-threaded epoll ingest of framed sensor streams (adxl345_ingest.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Linux only (epoll, termios).
+ *   - Descriptors are switched to O_NONBLOCK when added; level-triggered epoll
+ *     plus draining to EAGAIN keeps one slow port from starving the others.
+ *   - A stream is removed (and its descriptor closed) on EOF or hang-up.
+ *
+ *******************************************************************************
+ */
+
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+#include "adxl345_ingest.h"
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/epoll.h>
+
+/* --------------------------------------------------
+ * Helpers
+ * --------------------------------------------------*/
+
+static uint64_t nowNs(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief  Frame handler: parses block frames directly into the fan-out slots
+ *         and health / duty-cycle frames into the stream.
+ */
+static void onFrame(void *ctx, uint8_t type, const uint8_t *payload, uint8_t len){
+	ADXL_IngestType *ing = ctx;
+	ADXL_IngestStreamType *st = ing->current;
+	ADXL_BlockType *slot;
+
+	if(type == ADXL_FRAME_HEALTH){
+		if(adxlHealthParse(payload, len, &st->health)) st->health_frames++;
+		ing->frames++;
+		return;
+	}
+	if(type == ADXL_FRAME_DUTY){
+		if(adxlDutyParse(payload, len, &st->duty)) st->duty_frames++;
+		ing->frames++;
+		return;
+	}
+	if(type != ADXL_FRAME_BLOCK || len < ADXL_FRAME_BLOCK_HEADER) return;
+
+	if(ing->ring != NULL && (slot = adxlRingClaim(ing->ring)) != NULL){
+		if(adxlFrameParseBlock(payload, len, slot)){
+			slot->node = st->node;
+			adxlRingPublish(ing->ring);
+		}
+	}
+	if(ing->shm != NULL){
+		slot = adxlShmClaim(ing->shm);
+		if(adxlFrameParseBlock(payload, len, slot)){
+			slot->node = st->node;
+			adxlShmPublish(ing->shm);
+		}
+	}
+
+	/* Device block seq, read from the payload: a block dropped by a full ring
+	 * (ADXL_RING_DROP) is lost locally, not on the link, and is no gap */
+	uint32_t seq = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+			((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+
+	if(st->seq_valid && seq != st->next_seq) st->gaps++;
+	st->next_seq = seq + 1U;
+	st->seq_valid = 1;
+	ing->frames++;
+}
+
+/* --------------------------------------------------
+ * Setup
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Creates the epoll set.
+ * @param  ing: Pointer to ADXL_IngestType structure
+ * @param  ring: Fan-out ring for in-process consumers (may be NULL)
+ * @param  shm: Shared-memory publisher for other processes (may be NULL)
+ * @return 0 on success, -1 on failure
+ */
+int adxlIngestInit(ADXL_IngestType *ing, ADXL_RingType *ring, ADXL_ShmPubType *shm){
+	ing->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if(ing->epfd < 0){
+		printf("Error: epoll_create1 failed\r\n");
+		return -1;
+	}
+
+	ing->ring = ring;
+	ing->shm = shm;
+	ing->current = NULL;
+	ing->frames = 0;
+	ing->bytes = 0;
+	ing->busy_ns = 0;
+
+	for(int i = 0; i < ADXL_INGEST_MAX_STREAMS; i++) ing->stream[i].fd = -1;
+	return 0;
+}
+
+/**
+ * @brief  Removes every stream and closes the epoll set.
+ * @param  ing: Pointer to ADXL_IngestType structure
+ * @return None
+ */
+void adxlIngestClose(ADXL_IngestType *ing){
+	for(int i = 0; i < ADXL_INGEST_MAX_STREAMS; i++){
+		if(ing->stream[i].fd >= 0) adxlIngestRemove(ing, i);
+	}
+	close(ing->epfd);
+}
+
+/**
+ * @brief  Opens a serial port in raw, non-blocking mode.
+ * @param  dev: Device node (e.g. "/dev/ttyUSB0")
+ * @param  baud: 115200, 230400, 460800 or 921600
+ * @return File descriptor, or -1 on failure
+ */
+int adxlIngestOpenSerial(const char *dev, uint32_t baud){
+	struct termios tio;
+	speed_t speed;
+
+	switch(baud){
+	case 115200: speed = B115200; break;
+	case 230400: speed = B230400; break;
+	case 460800: speed = B460800; break;
+	case 921600: speed = B921600; break;
+	default:
+		printf("Error: Unsupported baud rate %u\r\n", (unsigned)baud);
+		return -1;
+	}
+
+	int fd = open(dev, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if(fd < 0){
+		printf("Error: Failed to open %s\r\n", dev);
+		return -1;
+	}
+
+	if(tcgetattr(fd, &tio) == 0){
+		cfmakeraw(&tio);
+		cfsetspeed(&tio, speed);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	return fd;
+}
+
+/**
+ * @brief  Adds a framed byte stream (serial port, pty, pipe or socket).
+ * @param  ing: Pointer to ADXL_IngestType structure
+ * @param  fd: Readable descriptor; ownership passes to the ingest loop
+ * @param  node: Node id stamped into every block from this stream
+ * @return Stream id, or -1 on failure
+ */
+int adxlIngestAdd(ADXL_IngestType *ing, int fd, uint16_t node){
+	if(fd < 0) return -1;
+
+	for(int i = 0; i < ADXL_INGEST_MAX_STREAMS; i++){
+		ADXL_IngestStreamType *st = &ing->stream[i];
+		if(st->fd >= 0) continue;
+
+		struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)i };
+
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		if(epoll_ctl(ing->epfd, EPOLL_CTL_ADD, fd, &ev) != 0){
+			printf("Error: epoll_ctl failed for fd %d\r\n", fd);
+			return -1;
+		}
+
+		st->fd = fd;
+		st->node = node;
+		st->next_seq = 0;
+		st->seq_valid = 0;
+		st->gaps = 0;
+		st->bytes = 0;
+		st->health_frames = 0;
+		st->health = (ADXL_HealthStatusType){0};
+		st->duty_frames = 0;
+		st->duty = (ADXL_DutyType){0};
+		adxlFrameDecoderInit(&st->dec);
+		return i;
+	}
+
+	printf("Error: Too many streams (max %d)\r\n", ADXL_INGEST_MAX_STREAMS);
+	return -1;
+}
+
+/**
+ * @brief  Removes a stream and closes its descriptor.
+ * @param  ing: Pointer to ADXL_IngestType structure
+ * @param  id: Stream id
+ * @return None
+ */
+void adxlIngestRemove(ADXL_IngestType *ing, int id){
+	ADXL_IngestStreamType *st = &ing->stream[id];
+
+	epoll_ctl(ing->epfd, EPOLL_CTL_DEL, st->fd, NULL);
+	close(st->fd);
+	st->fd = -1;
+}
+
+/* --------------------------------------------------
+ * Loop
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Waits for readable streams and processes everything that arrived.
+ * @param  ing: Pointer to ADXL_IngestType structure
+ * @param  timeout_ms: epoll_wait() timeout (-1: forever)
+ * @return Number of frames decoded, or -1 on error
+ */
+int adxlIngestRun(ADXL_IngestType *ing, int timeout_ms){
+	struct epoll_event ev[ADXL_INGEST_EVENTS];
+	uint8_t buf[ADXL_INGEST_READ_SIZE];
+	uint64_t frames = ing->frames;
+
+	int n = epoll_wait(ing->epfd, ev, ADXL_INGEST_EVENTS, timeout_ms);
+	if(n < 0) return (errno == EINTR) ? 0 : -1;
+
+	uint64_t start = nowNs();
+
+	for(int i = 0; i < n; i++){
+		int id = (int)ev[i].data.u32;
+		ADXL_IngestStreamType *st = &ing->stream[id];
+		uint8_t closed = 0;
+
+		if(st->fd < 0) continue;
+		ing->current = st;
+
+		for(;;){
+			ssize_t r = read(st->fd, buf, sizeof(buf));
+			if(r > 0){
+				st->bytes += (uint64_t)r;
+				ing->bytes += (uint64_t)r;
+				adxlFrameDecode(&st->dec, buf, (uint32_t)r, onFrame, ing);
+				if((size_t)r < sizeof(buf)) break;   //*Short read: drained
+			}
+			else if(r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+				break;
+			}
+			else if(r < 0 && errno == EINTR){
+				continue;
+			}
+			else{
+				closed = 1;                          //*EOF or error
+				break;
+			}
+		}
+
+		/* Hang-up with data pending is handled once the data has been read */
+		if(closed || !(ev[i].events & EPOLLIN)) adxlIngestRemove(ing, id);
+	}
+
+	ing->busy_ns += nowNs() - start;
+	return (int)(ing->frames - frames);
+}
+
+/**
+ * @brief  Average processing cost per decoded frame.
+ * @param  ing: Pointer to ADXL_IngestType structure
+ * @return Nanoseconds per frame (0 before the first frame)
+ */
+uint32_t adxlIngestFrameCostNs(const ADXL_IngestType *ing){
+	if(ing->frames == 0) return 0;
+	return (uint32_t)(ing->busy_ns / ing->frames);
+}
+
+#endif /* __linux__ */
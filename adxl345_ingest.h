@@ -0,0 +1,95 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_ingest.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Single-threaded epoll ingest of framed sensor streams (adxl345_ingest.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - One thread, one epoll set, any number of serial ports / pipes / sockets / ptys
+ *   - Every readable descriptor is drained until EAGAIN and the whole buffer is
+ *     decoded in one pass (adxl345_frame.c)
+ *   - Decoded blocks are written straight into the fan-out ring slot and/or the
+ *     shared-memory slot; consumers (recorder, subscribers) read them in place
+ *   - Health frames update the stream's 'health' (last status received),
+ *     duty-cycle frames its 'duty'
+ *   - Processing time is measured per batch, giving a per-frame cost
+ *
+ *  @usage
+ *   adxlIngestInit(&ing, &ring, &shm);                  // either may be NULL
+ *   adxlIngestAdd(&ing, adxlIngestOpenSerial("/dev/ttyUSB0", 921600), 1);
+ *   for(;;) adxlIngestRun(&ing, 100);
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_INGEST_H_
+#define INC_ADXL345_INGEST_H_
+
+#include "adxl345_frame.h"
+#include "adxl345_ring.h"
+#include "adxl345_shm.h"
+
+/* --------------------------------------------------
+ * 1. Ingest setting value define
+ * --------------------------------------------------*/
+
+#ifndef ADXL_INGEST_MAX_STREAMS
+#define ADXL_INGEST_MAX_STREAMS 512
+#endif
+
+#define ADXL_INGEST_READ_SIZE 4096   //*Bytes per read()
+#define ADXL_INGEST_EVENTS 64        //*Events per epoll_wait()
+
+/* --------------------------------------------------
+ * 2. Ingest Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	int fd;                          //*-1: slot unused
+	uint16_t node;
+	ADXL_FrameDecoderType dec;
+	uint32_t next_seq;
+	uint8_t seq_valid;               //*next_seq set by a block frame
+	uint32_t gaps;                   //*Sequence discontinuities (lost frames)
+	uint64_t bytes;
+	ADXL_HealthStatusType health;    //*Last ADXL_FRAME_HEALTH received
+	uint32_t health_frames;          //*0: no health frame yet
+	ADXL_DutyType duty;              //*Last ADXL_FRAME_DUTY received
+	uint32_t duty_frames;            //*0: no duty-cycle frame yet
+} ADXL_IngestStreamType;
+
+typedef struct{
+	int epfd;
+	ADXL_RingType *ring;             //*In-process consumers (may be NULL)
+	ADXL_ShmPubType *shm;            //*Other processes (may be NULL)
+
+	ADXL_IngestStreamType stream[ADXL_INGEST_MAX_STREAMS];
+	ADXL_IngestStreamType *current;  //*Stream being decoded
+
+	uint64_t frames;
+	uint64_t bytes;
+	uint64_t busy_ns;                //*Time spent reading, decoding and fanning out
+} ADXL_IngestType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+int adxlIngestInit(ADXL_IngestType *ing, ADXL_RingType *ring, ADXL_ShmPubType *shm);
+void adxlIngestClose(ADXL_IngestType *ing);
+
+int adxlIngestOpenSerial(const char *dev, uint32_t baud);
+int adxlIngestAdd(ADXL_IngestType *ing, int fd, uint16_t node);
+void adxlIngestRemove(ADXL_IngestType *ing, int id);
+
+int adxlIngestRun(ADXL_IngestType *ing, int timeout_ms);
+uint32_t adxlIngestFrameCostNs(const ADXL_IngestType *ing);
+
+#endif /* INC_ADXL345_INGEST_H_ */
@@ -0,0 +1,232 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_linux.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Linux i2c-dev / spidev transport for the ADXL345 driver (adxl345_linux.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Every register access is a single ioctl: no per-byte system calls.
+ *   - The I2C address is the 7-bit address (0x53 or 0x1D), not the HAL's shifted one.
+ *
+ *******************************************************************************
+ */
+
+#if defined(ADXL_USE_LINUX)
+
+#include "adxl345.h"
+#include "adxl345_sim.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
+
+#define SPI_READ 0x80
+#define SPI_MULTIBYTE 0x40
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+static int bus_fd = -1;
+static uint8_t bus_spi = 0;
+static uint8_t bus_address = 0x53;
+
+static int deviceIoctl(int fd, unsigned long request, void *arg){
+	return ioctl(fd, request, arg);
+}
+
+static int (*bus_ioctl)(int fd, unsigned long request, void *arg) = deviceIoctl;
+
+/* --------------------------------------------------
+ * Open / Close
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Opens an i2c-dev adapter.
+ * @param  dev: Device node (e.g. "/dev/i2c-1")
+ * @param  address: 7-bit slave address (0x53 or 0x1D)
+ * @return 0 on success, -1 on failure
+ */
+int adxlLinuxOpenI2C(const char *dev, uint8_t address){
+	adxlLinuxClose();
+
+	bus_fd = open(dev, O_RDWR);
+	if(bus_fd < 0){
+		printf("Error: Failed to open %s\r\n", dev);
+		return -1;
+	}
+	bus_ioctl = deviceIoctl;
+	bus_spi = 0;
+	bus_address = address;
+	return 0;
+}
+
+/**
+ * @brief  Opens a spidev device in mode 3.
+ * @param  dev: Device node (e.g. "/dev/spidev0.0")
+ * @param  speed_hz: SCLK frequency (ADXL345 maximum: 5 MHz)
+ * @return 0 on success, -1 on failure
+ */
+int adxlLinuxOpenSPI(const char *dev, uint32_t speed_hz){
+	uint8_t mode = ADXL_SPI_MODE;
+	uint8_t bits = 8;
+
+	adxlLinuxClose();
+
+	bus_fd = open(dev, O_RDWR);
+	if(bus_fd < 0){
+		printf("Error: Failed to open %s\r\n", dev);
+		return -1;
+	}
+	bus_ioctl = deviceIoctl;
+	bus_spi = 1;
+
+	if(bus_ioctl(bus_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+			bus_ioctl(bus_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+			bus_ioctl(bus_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0){
+		printf("Error: Failed to configure %s\r\n", dev);
+		adxlLinuxClose();
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief  Opens the simulator stand-in (test mode).
+ * @param  spi: 1 to exercise the spidev path, 0 for the i2c-dev path
+ * @return 0 on success, -1 on failure
+ * @note   The simulator is reset to power-on state.
+ */
+int adxlLinuxOpenSim(uint8_t spi){
+	uint32_t speed = 5000000U;
+
+	adxlLinuxClose();
+	adxlSimReset(NULL);
+
+	bus_fd = adxlSimOpen();
+	if(bus_fd < 0) return -1;
+
+	bus_ioctl = adxlSimIoctl;
+	bus_spi = spi;
+	bus_address = 0x53;
+	if(spi) bus_ioctl(bus_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed);
+	return 0;
+}
+
+/**
+ * @brief  Closes the current bus.
+ * @return None
+ */
+void adxlLinuxClose(void){
+	if(bus_fd >= 0) close(bus_fd);
+	bus_fd = -1;
+}
+
+/**
+ * @brief  Switches to a descriptor opened elsewhere (device handles, adxlSelect()).
+ * @param  fd: Open i2c-dev / spidev descriptor (or adxlSimOpen())
+ * @param  spi: 1 for spidev, 0 for i2c-dev
+ * @param  address: I2C 7-bit address
+ * @param  sim: 1 if fd is the simulator stand-in
+ * @return None
+ * @note   The previous descriptor is not closed; its owner closes it.
+ */
+void adxlLinuxAttach(int fd, uint8_t spi, uint8_t address, uint8_t sim){
+	bus_fd = fd;
+	bus_spi = spi;
+	bus_address = address;
+	bus_ioctl = sim ? adxlSimIoctl : deviceIoctl;
+}
+
+/**
+ * @brief  Returns the current bus (for adxlLinuxAttach() later).
+ * @param  spi: Receives 1 for spidev, 0 for i2c-dev
+ * @param  address: Receives the I2C 7-bit address
+ * @param  sim: Receives 1 for the simulator stand-in
+ * @return Descriptor, -1 if none is open
+ */
+int adxlLinuxCurrent(uint8_t *spi, uint8_t *address, uint8_t *sim){
+	*spi = bus_spi;
+	*address = bus_address;
+	*sim = (uint8_t)(bus_ioctl == adxlSimIoctl);
+	return bus_fd;
+}
+
+/* --------------------------------------------------
+ * Register Access
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Writes consecutive registers in one transaction.
+ * @param  reg_address: First register
+ * @param  data: Values to write
+ * @param  len: Number of registers (1 .. ADXL_LINUX_MAX_BURST - 1)
+ * @return ADXL_OK on success, ADXL_ERROR on failure
+ */
+uint8_t adxlLinuxWrite(uint8_t reg_address, const uint8_t *data, uint16_t len){
+	uint8_t buf[ADXL_LINUX_MAX_BURST];
+
+	if(bus_fd < 0 || len == 0 || len >= ADXL_LINUX_MAX_BURST) return ADXL_ERROR;
+
+	memcpy(&buf[1], data, len);
+
+	if(bus_spi){
+		struct spi_ioc_transfer xfer = {0};
+
+		buf[0] = reg_address | ((len > 1) ? SPI_MULTIBYTE : 0);
+		xfer.tx_buf = (uintptr_t)buf;
+		xfer.len = len + 1U;
+		return (bus_ioctl(bus_fd, SPI_IOC_MESSAGE(1), &xfer) < 0) ? ADXL_ERROR : ADXL_OK;
+	}
+	else{
+		struct i2c_msg msg = { bus_address, 0, (uint16_t)(len + 1U), buf };
+		struct i2c_rdwr_ioctl_data rdwr = { &msg, 1 };
+
+		buf[0] = reg_address;
+		return (bus_ioctl(bus_fd, I2C_RDWR, &rdwr) < 0) ? ADXL_ERROR : ADXL_OK;
+	}
+}
+
+/**
+ * @brief  Reads consecutive registers in one transaction.
+ * @param  reg_address: First register
+ * @param  data: Buffer for the values
+ * @param  len: Number of registers (1 .. ADXL_LINUX_MAX_BURST - 1)
+ * @return ADXL_OK on success, ADXL_ERROR on failure
+ */
+uint8_t adxlLinuxRead(uint8_t reg_address, uint8_t *data, uint16_t len){
+	if(bus_fd < 0 || len == 0 || len >= ADXL_LINUX_MAX_BURST) return ADXL_ERROR;
+
+	if(bus_spi){
+		uint8_t tx[ADXL_LINUX_MAX_BURST] = {0};
+		uint8_t rx[ADXL_LINUX_MAX_BURST];
+		struct spi_ioc_transfer xfer = {0};
+
+		tx[0] = SPI_READ | reg_address | ((len > 1) ? SPI_MULTIBYTE : 0);
+		xfer.tx_buf = (uintptr_t)tx;
+		xfer.rx_buf = (uintptr_t)rx;
+		xfer.len = len + 1U;
+		if(bus_ioctl(bus_fd, SPI_IOC_MESSAGE(1), &xfer) < 0) return ADXL_ERROR;
+
+		memcpy(data, &rx[1], len);
+		return ADXL_OK;
+	}
+	else{
+		/* Register pointer write + repeated-start read in one I2C_RDWR */
+		struct i2c_msg msg[2] = {
+			{ bus_address, 0, 1, &reg_address },
+			{ bus_address, I2C_M_RD, len, data }
+		};
+		struct i2c_rdwr_ioctl_data rdwr = { msg, 2 };
+
+		return (bus_ioctl(bus_fd, I2C_RDWR, &rdwr) < 0) ? ADXL_ERROR : ADXL_OK;
+	}
+}
+
+#endif /* ADXL_USE_LINUX */
@@ -0,0 +1,55 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_linux.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Linux i2c-dev / spidev transport for the ADXL345 driver (adxl345_linux.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Replaces the STM32 HAL bus calls when the driver is built with -DADXL_USE_LINUX
+ *   - I2C: one I2C_RDWR ioctl per access (register write + repeated-start read)
+ *   - SPI: one full-duplex SPI_IOC_MESSAGE per access (multi-byte bit set for bursts)
+ *   - adxlLinuxOpenSim() routes the same ioctls to adxl345_sim.c instead of a device
+ *
+ *  @usage
+ *   adxlLinuxOpenI2C("/dev/i2c-1", 0x53);    // or adxlLinuxOpenSPI("/dev/spidev0.0", 5000000);
+ *   adxlInit(&Config);
+ *   int16_t x = read_X();
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_LINUX_H_
+#define INC_ADXL345_LINUX_H_
+
+#include <stddef.h>
+#include "adxl345_types.h"
+
+/* --------------------------------------------------
+ * 1. Transport setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_LINUX_MAX_BURST 64      //*Largest single transfer (bytes)
+#define ADXL_SPI_MODE 3              //*ADXL345: CPOL = 1, CPHA = 1
+
+/* --------------------------------------------------
+ * 2. function define
+ * --------------------------------------------------*/
+
+int adxlLinuxOpenI2C(const char *dev, uint8_t address);
+int adxlLinuxOpenSPI(const char *dev, uint32_t speed_hz);
+int adxlLinuxOpenSim(uint8_t spi);
+void adxlLinuxClose(void);
+void adxlLinuxAttach(int fd, uint8_t spi, uint8_t address, uint8_t sim);
+int adxlLinuxCurrent(uint8_t *spi, uint8_t *address, uint8_t *sim);
+
+uint8_t adxlLinuxWrite(uint8_t reg_address, const uint8_t *data, uint16_t len);
+uint8_t adxlLinuxRead(uint8_t reg_address, uint8_t *data, uint16_t len);
+
+#endif /* INC_ADXL345_LINUX_H_ */
@@ -0,0 +1,174 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_orient.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Orientation / face-up event engine (adxl345_orient.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Link mode arms inactivity first, so the initial face is reported after
+ *     the first settle_s seconds without any polling.
+ *   - FIFO in bypass: the data registers hold the newest sample, so one
+ *     6-byte read classifies. A settle event costs two transactions
+ *     (INT_SOURCE + data), an activity event one.
+ *   - Auto-sleep stays off: the tracking rate is already the low one.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_orient.h"
+
+/**
+ * @brief  Classifies a sample (mg) into a face, with hysteresis.
+ * @param  mg: X, Y, Z in mg
+ * @param  current: Current face (ADXL_FACE_UNKNOWN: none yet)
+ * @param  enter_mg: Component needed to take a new face
+ * @param  leave_mg: Component below which the current face is released
+ * @return New face (the current one if no face is clear enough)
+ */
+uint8_t adxlOrientClassify(const int16_t mg[3], uint8_t current, uint16_t enter_mg, uint16_t leave_mg){
+	uint8_t axis = 0;
+	int32_t best = 0;
+
+	if(current != ADXL_FACE_UNKNOWN){
+		uint8_t a = (uint8_t)((current - 1) / 2);
+		int32_t v = ((current - 1) & 1) ? -mg[a] : mg[a];
+		if(v >= leave_mg) return current;
+	}
+
+	for(uint8_t a = 0; a < 3; a++){
+		int32_t v = (mg[a] < 0) ? -mg[a] : mg[a];
+		if(v > best){
+			best = v;
+			axis = a;
+		}
+	}
+	if(best < enter_mg) return current;
+
+	return (uint8_t)(ADXL_FACE_X_UP + axis * 2 + ((mg[axis] < 0) ? 1 : 0));
+}
+
+/**
+ * @brief  Configures the sensor for orientation tracking and starts measuring.
+ * @param  orient: Pointer to ADXL_OrientType structure
+ * @param  config: Configuration
+ * @param  now_ms: Current time in milliseconds
+ * @return ADXL_OK, or ADXL_ERROR on bus failure
+ * @note   Replaces BW_RATE, FIFO_CTL, INT_ENABLE and the ACTIVITY / INACTIVITY
+ *         bits of INT_MAP. The face is UNKNOWN until the first settle event.
+ */
+uint8_t adxlOrientStart(ADXL_OrientType *orient, const ADXL_OrientConfigType *config, uint32_t now_ms){
+	ADXL_PowerConfigType power = ADXL_POWER_DEFAULT;
+	const uint8_t *shadow = getShadow();
+	uint8_t standby = shadow[POWER_CTL - ADXL_SHADOW_FIRST] & (uint8_t)~(MEASURE_ON | SLEEPMODE_ON | AUTOSLEEPMODE_ON);
+	uint8_t fifo_ctl = FIFO_BYPASS;
+	uint8_t int_enable = ACTIVITY_ON | INACTIVITY_ON;
+	uint8_t int_map = shadow[INT_MAP - ADXL_SHADOW_FIRST] & (uint8_t)~(ACTIVITY_ON | INACTIVITY_ON);
+	uint8_t measure;
+
+	*orient = (ADXL_OrientType){0};
+	orient->config = *config;
+	orient->start_ms = now_ms;
+	adxlPowerInit(&orient->power, now_ms);
+
+	if(config->quiet_activity) int_map |= ACTIVITY_ON;  //*1 = INT2
+
+	/* Rate and FIFO in standby */
+	if(writeBurst(POWER_CTL, &standby, 1) != ADXL_OK) return ADXL_ERROR;
+	if(writeBurst(BW_RATE, &config->bw_rate, 1) != ADXL_OK) return ADXL_ERROR;
+	if(writeBurst(FIFO_CTL, &fifo_ctl, 1) != ADXL_OK) return ADXL_ERROR;
+
+	power.act_mg = config->act_mg;
+	power.inact_mg = config->settle_mg;
+	power.inact_s = (config->settle_s != 0) ? config->settle_s : 1;
+	power.act_ac = 1;
+	power.inact_ac = 1;
+	power.link = LINKMODE_ON;
+	power.autosleep = AUTOSLEEPMODE_OFF;
+	power.interrupts = 0;
+	if(adxlPowerConfigure(&orient->power, &power) != ADXL_OK) return ADXL_ERROR;
+
+	/* Only motion and settling may interrupt */
+	if(writeBurst(INT_MAP, &int_map, 1) != ADXL_OK) return ADXL_ERROR;
+	if(writeBurst(INT_ENABLE, &int_enable, 1) != ADXL_OK) return ADXL_ERROR;
+
+	measure = getShadow()[POWER_CTL - ADXL_SHADOW_FIRST] | MEASURE_ON;
+	if(writeBurst(POWER_CTL, &measure, 1) != ADXL_OK) return ADXL_ERROR;
+
+	markConfigChange();
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Reads the newest sample and classifies it; emits an event on change.
+ * @param  orient: Pointer to ADXL_OrientType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return 1 if the face changed, 0 otherwise
+ */
+uint8_t adxlOrientRefresh(ADXL_OrientType *orient, uint32_t now_ms){
+	uint8_t raw[6];
+	int32_t scale = scaleOf(getShadow()[DATA_FORMAT - ADXL_SHADOW_FIRST]);
+	int32_t sq = 0, lo, hi;
+	uint8_t face, previous;
+
+	if(readBurst(DATAX0, raw, 6) != ADXL_OK) return 0;
+
+	for(uint8_t a = 0; a < 3; a++){
+		int16_t v = (int16_t)((raw[a * 2 + 1] << 8) | raw[a * 2]);
+		orient->mg[a] = (int16_t)((v * scale) >> 8);
+		sq += (int32_t)orient->mg[a] * orient->mg[a];
+	}
+	orient->settles++;
+
+	/* Not at rest in gravity only: keep the face */
+	lo = 1000 - orient->config.gravity_tol_mg;
+	hi = 1000 + orient->config.gravity_tol_mg;
+	if(sq < lo * lo || sq > hi * hi){
+		orient->rejected++;
+		return 0;
+	}
+
+	previous = orient->face;
+	face = adxlOrientClassify(orient->mg, previous, orient->config.enter_mg, orient->config.leave_mg);
+	if(face == previous) return 0;
+
+	orient->face = face;
+	orient->changes++;
+	if(orient->on_change != NULL) orient->on_change(face, previous, now_ms);
+	return 1;
+}
+
+/**
+ * @brief  Handles an INT1 event: motion starts or the device has settled.
+ * @param  orient: Pointer to ADXL_OrientType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return 1 if the face changed, 0 otherwise
+ * @note   Reads INT_SOURCE (clears the latched events).
+ */
+uint8_t adxlOrientOnInterrupt(ADXL_OrientType *orient, uint32_t now_ms){
+	uint8_t int_source;
+
+	orient->wakeups++;
+	if(readBurst(INT_SOURCE, &int_source, 1) != ADXL_OK) return 0;
+
+	if(int_source & ACTIVITY_INT) orient->moving = 1;
+	if(!(int_source & INACTIVITY_INT)) return 0;
+
+	orient->moving = 0;
+	return adxlOrientRefresh(orient, now_ms);
+}
+
+/**
+ * @brief  Average MCU wake-up rate since adxlOrientStart().
+ * @param  orient: Pointer to ADXL_OrientType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return Wake-ups per hour
+ */
+uint32_t adxlOrientWakeupsPerHour(const ADXL_OrientType *orient, uint32_t now_ms){
+	uint32_t elapsed = now_ms - orient->start_ms;
+
+	if(elapsed == 0) return 0;
+	return (uint32_t)((uint64_t)orient->wakeups * 3600000U / elapsed);
+}
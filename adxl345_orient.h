@@ -0,0 +1,104 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_orient.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Orientation / face-up event engine (adxl345_orient.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Six faces (which axis points up, and its sign); portrait / landscape /
+ *     flat follow from the face
+ *   - The sensor runs at a low rate in low-power mode with linked AC-coupled
+ *     activity and inactivity; no data-ready or FIFO interrupts
+ *   - Debounce in hardware: the face is classified only when the device has
+ *     been still for settle_s seconds (inactivity), from one sample
+ *   - Hysteresis: a new face needs enter_mg on its axis, the current face is
+ *     kept while its axis stays above leave_mg
+ *   - Samples off 1 g (moving, vibrating) are rejected, the face is kept
+ *   - Change events only (on_change); wake-ups are counted
+ *   - quiet_activity routes ACTIVITY to INT2 (left unconnected) so only the
+ *     settle event wakes the MCU: one wake-up per orientation change
+ *
+ *  @usage
+ *   ADXL_OrientType orient;
+ *   ADXL_OrientConfigType cfg = ADXL_ORIENT_DEFAULT;
+ *   adxlOrientStart(&orient, &cfg, HAL_GetTick());
+ *   orient.on_change = myFaceChanged;
+ *   EXTI (INT1):  adxlOrientOnInterrupt(&orient, HAL_GetTick());
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_ORIENT_H_
+#define INC_ADXL345_ORIENT_H_
+
+#include "adxl345.h"
+#include "adxl345_power.h"
+
+/* --------------------------------------------------
+ * 1. Orientation setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_FACE_UNKNOWN 0
+#define ADXL_FACE_X_UP 1
+#define ADXL_FACE_X_DOWN 2
+#define ADXL_FACE_Y_UP 3
+#define ADXL_FACE_Y_DOWN 4
+#define ADXL_FACE_Z_UP 5
+#define ADXL_FACE_Z_DOWN 6
+
+#define ADXL_FACE_IS_PORTRAIT(face) ((face) == ADXL_FACE_Y_UP || (face) == ADXL_FACE_Y_DOWN)
+#define ADXL_FACE_IS_LANDSCAPE(face) ((face) == ADXL_FACE_X_UP || (face) == ADXL_FACE_X_DOWN)
+#define ADXL_FACE_IS_FLAT(face) ((face) == ADXL_FACE_Z_UP || (face) == ADXL_FACE_Z_DOWN)
+
+/** 12.5 Hz low power, 250 mg activity, still within 125 mg for 1 s, enter 800 mg / leave 600 mg */
+#define ADXL_ORIENT_DEFAULT { \
+	.bw_rate = LP_LOWPOWER | BWRATE_12_5, .act_mg = 250, .settle_mg = 125, .settle_s = 1, \
+	.enter_mg = 800, .leave_mg = 600, .gravity_tol_mg = 250, .quiet_activity = 0 }
+
+/* --------------------------------------------------
+ * 2. Orientation Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint8_t bw_rate;                 //*BW_RATE while tracking (rate code | LP_LOWPOWER)
+	uint16_t act_mg;                 //*Motion that wakes the engine (AC-coupled)
+	uint16_t settle_mg;              //*Still = every axis within this of its reference
+	uint8_t settle_s;                //*... for this long (debounce, 1 .. 255 s)
+	uint16_t enter_mg;               //*Axis component needed to take a new face
+	uint16_t leave_mg;               //*Current face kept while its component stays above
+	uint16_t gravity_tol_mg;         //*| |a| - 1 g | allowed for a valid sample
+	uint8_t quiet_activity;          //*1: ACTIVITY on INT2, only settling wakes the MCU
+} ADXL_OrientConfigType;
+
+typedef struct{
+	ADXL_OrientConfigType config;
+	ADXL_PowerType power;            //*Activity / inactivity setup
+	uint8_t face;                    //*ADXL_FACE_xxx
+	uint8_t moving;                  //*1 between ACTIVITY and INACTIVITY
+	int16_t mg[3];                   //*Last classified sample
+	uint32_t start_ms;
+	uint32_t wakeups;                //*Interrupts handled
+	uint32_t settles;                //*Classifications
+	uint32_t changes;                //*Change events
+	uint32_t rejected;               //*Samples off 1 g
+	void (*on_change)(uint8_t face, uint8_t previous, uint32_t now_ms);
+} ADXL_OrientType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+uint8_t adxlOrientStart(ADXL_OrientType *orient, const ADXL_OrientConfigType *config, uint32_t now_ms);
+uint8_t adxlOrientOnInterrupt(ADXL_OrientType *orient, uint32_t now_ms);
+uint8_t adxlOrientRefresh(ADXL_OrientType *orient, uint32_t now_ms);
+uint8_t adxlOrientClassify(const int16_t mg[3], uint8_t current, uint16_t enter_mg, uint16_t leave_mg);
+uint32_t adxlOrientWakeupsPerHour(const ADXL_OrientType *orient, uint32_t now_ms);
+
+#endif /* INC_ADXL345_ORIENT_H_ */
@@ -0,0 +1,342 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_pipeline.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Built-in pipeline stages (adxl345_pipeline.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - All stages work in place on ADXL_BlockType samples.
+ *   - After adxlStageConvert() samples are in mg (int16 covers +/-16 g).
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_pipeline.h"
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+ADXL_StatsType adxlStats = {
+	{ INT16_MAX, INT16_MAX, INT16_MAX }, { INT16_MIN, INT16_MIN, INT16_MIN }, { 0 }, { 0 }, 0
+};
+
+ADXL_CalibType adxlCalib = {
+	{ 0, 0, 0 },
+	{ { ADXL_CALIB_ONE, 0, 0 }, { 0, ADXL_CALIB_ONE, 0 }, { 0, 0, ADXL_CALIB_ONE } }
+};
+
+static ADXL_FilterType filter_default;
+ADXL_FilterType *adxlFilter = &filter_default;   //*Set by <name>_run() to the pipeline's own state
+
+_Static_assert(sizeof(ADXL_SampleType) == 6, "per-axis loops step through samples as int16_t[3]");
+
+/** Axis index (0 = X) enabled in a block */
+#define AXIS_ON(block, a) (!((block)->axes_off & (ADXL_AXIS_X >> (a))))
+
+/**
+ * @brief  Enables the DWT cycle counter used for per-stage timing.
+ * @return None
+ */
+void adxlCycleInit(void){
+#if !defined(ADXL_USE_LINUX)
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/* --------------------------------------------------
+ * Stages
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Acquire: drains up to block->count FIFO entries.
+ * @param  block: Pipeline block
+ * @return None
+ */
+void adxlStageAcquire(ADXL_BlockType *block){
+	drainFifoN(block, (uint8_t)block->count);
+}
+
+/**
+ * @brief  Convert: raw LSB to mg using the range/resolution stamped in the block.
+ * @param  block: Pipeline block
+ * @return None
+ * @note   Axes listed in block->axes_off are skipped.
+ */
+void adxlStageConvert(ADXL_BlockType *block){
+	int32_t scale = scaleOf(block->data_format);
+
+	if(block->axes_off == 0){
+		for(uint16_t i = 0; i < block->count; i++){
+			ADXL_SampleType *s = &block->samples[i];
+			s->x = (int16_t)((s->x * scale) >> 8);
+			s->y = (int16_t)((s->y * scale) >> 8);
+			s->z = (int16_t)((s->z * scale) >> 8);
+		}
+		return;
+	}
+
+	for(uint8_t a = 0; a < 3; a++){
+		if(!AXIS_ON(block, a)) continue;
+		int16_t *v = &block->samples[0].x + a;
+		for(uint16_t i = 0; i < block->count; i++, v += 3) *v = (int16_t)((*v * scale) >> 8);
+	}
+}
+
+/**
+ * @brief  Filter: first-order IIR low-pass, y += alpha * (x - y).
+ * @param  block: Pipeline block
+ * @return None
+ * @note   State (adxlFilter, the running pipeline's) is kept in Q8 to avoid
+ *         truncation bias at small alpha. Axes listed in block->axes_off are skipped.
+ */
+void adxlStageFilter(ADXL_BlockType *block){
+	ADXL_FilterType *flt = adxlFilter;
+
+	if(block->count == 0) return;
+
+	if(!flt->primed){
+		flt->state[0] = (int32_t)block->samples[0].x << 8;
+		flt->state[1] = (int32_t)block->samples[0].y << 8;
+		flt->state[2] = (int32_t)block->samples[0].z << 8;
+		flt->primed = 1;
+	}
+
+	if(block->axes_off == 0){
+		for(uint16_t i = 0; i < block->count; i++){
+			ADXL_SampleType *s = &block->samples[i];
+			flt->state[0] += (int32_t)(((int64_t)(((int32_t)s->x << 8) - flt->state[0]) * ADXL_FILTER_ALPHA) >> 15);
+			flt->state[1] += (int32_t)(((int64_t)(((int32_t)s->y << 8) - flt->state[1]) * ADXL_FILTER_ALPHA) >> 15);
+			flt->state[2] += (int32_t)(((int64_t)(((int32_t)s->z << 8) - flt->state[2]) * ADXL_FILTER_ALPHA) >> 15);
+			s->x = (int16_t)(flt->state[0] >> 8);
+			s->y = (int16_t)(flt->state[1] >> 8);
+			s->z = (int16_t)(flt->state[2] >> 8);
+		}
+		return;
+	}
+
+	for(uint8_t a = 0; a < 3; a++){
+		if(!AXIS_ON(block, a)) continue;
+		int16_t *v = &block->samples[0].x + a;
+		int32_t f = flt->state[a];
+		for(uint16_t i = 0; i < block->count; i++, v += 3){
+			f += (int32_t)(((int64_t)(((int32_t)*v << 8) - f) * ADXL_FILTER_ALPHA) >> 15);
+			*v = (int16_t)(f >> 8);
+		}
+		flt->state[a] = f;
+	}
+}
+
+/**
+ * @brief  Calibrate: v = M * (v - offset), using adxlCalib.
+ * @param  block: Pipeline block (mg)
+ * @return None
+ * @note   Disabled axes contribute 0 and are left untouched.
+ */
+void adxlStageCalibrate(ADXL_BlockType *block){
+	const ADXL_CalibType *c = &adxlCalib;
+	const uint8_t off = block->axes_off;
+
+	for(uint16_t i = 0; i < block->count; i++){
+		ADXL_SampleType *s = &block->samples[i];
+		int32_t x = (off & ADXL_AXIS_X) ? 0 : s->x - c->offset[0];
+		int32_t y = (off & ADXL_AXIS_Y) ? 0 : s->y - c->offset[1];
+		int32_t z = (off & ADXL_AXIS_Z) ? 0 : s->z - c->offset[2];
+
+		if(!(off & ADXL_AXIS_X)) s->x = (int16_t)((x * c->matrix[0][0] + y * c->matrix[0][1] + z * c->matrix[0][2]) >> 14);
+		if(!(off & ADXL_AXIS_Y)) s->y = (int16_t)((x * c->matrix[1][0] + y * c->matrix[1][1] + z * c->matrix[1][2]) >> 14);
+		if(!(off & ADXL_AXIS_Z)) s->z = (int16_t)((x * c->matrix[2][0] + y * c->matrix[2][1] + z * c->matrix[2][2]) >> 14);
+	}
+}
+
+/**
+ * @brief  Stats: per-axis min/max/sum/sum of squares into adxlStats.
+ * @param  block: Pipeline block
+ * @return None
+ * @note   Disabled axes are not accumulated.
+ */
+void adxlStageStats(ADXL_BlockType *block){
+	ADXL_StatsType *st = &adxlStats;
+
+	for(uint8_t a = 0; a < 3; a++){
+		if(!AXIS_ON(block, a)) continue;
+		const int16_t *v = &block->samples[0].x + a;
+		int16_t mn = st->min[a], mx = st->max[a];
+		int32_t sum = 0;
+		uint64_t sum_sq = 0;
+
+		for(uint16_t i = 0; i < block->count; i++, v += 3){
+			if(*v < mn) mn = *v;
+			if(*v > mx) mx = *v;
+			sum += *v;
+			sum_sq += (uint64_t)((int32_t)*v * *v);
+		}
+		st->min[a] = mn;
+		st->max[a] = mx;
+		st->sum[a] += sum;
+		st->sum_sq[a] += sum_sq;
+	}
+	st->count += block->count;
+}
+
+/**
+ * @brief  Clears window statistics.
+ * @param  stats: Pointer to ADXL_StatsType structure
+ * @return None
+ */
+void adxlStatsReset(ADXL_StatsType *stats){
+	for(uint8_t a = 0; a < 3; a++){
+		stats->min[a] = INT16_MAX;
+		stats->max[a] = INT16_MIN;
+		stats->sum[a] = 0;
+		stats->sum_sq[a] = 0;
+	}
+	stats->count = 0;
+}
+
+/**
+ * @brief  Clears filter state; the next sample seeds the filter again.
+ * @param  filter: Pointer to ADXL_FilterType structure (e.g. &vib_filter)
+ * @return None
+ */
+void adxlFilterReset(ADXL_FilterType *filter){
+	filter->state[0] = 0;
+	filter->state[1] = 0;
+	filter->state[2] = 0;
+	filter->primed = 0;
+}
+
+/* --------------------------------------------------
+ * Fused Kernel
+ * --------------------------------------------------*/
+
+/**
+ * @brief  One pass of decode + convert + calibrate + filter + statistics.
+ * @param  raw: FIFO bytes, 6 per sample (X0 X1 Y0 Y1 Z0 Z1); may alias out->samples
+ * @param  count: Number of samples
+ * @param  out: Destination block
+ * @param  diagonal: Constant at each call site, selects the diagonal-matrix path
+ * @return None
+ * @note   Filter state and statistics live in registers for the whole block
+ *         and are written back once, so each sample is loaded and stored once.
+ */
+static inline __attribute__((always_inline)) void fusedBody(const uint8_t *raw, uint16_t count,
+		ADXL_BlockType *out, const uint8_t diagonal){
+	const ADXL_CalibType *c = &adxlCalib;
+	ADXL_FilterType *flt = adxlFilter;
+	const int32_t scale = scaleOf(out->data_format);
+	int32_t f0, f1, f2;
+	int16_t mn0 = adxlStats.min[0], mn1 = adxlStats.min[1], mn2 = adxlStats.min[2];
+	int16_t mx0 = adxlStats.max[0], mx1 = adxlStats.max[1], mx2 = adxlStats.max[2];
+	int32_t s0 = 0, s1 = 0, s2 = 0;
+	uint64_t q0 = 0, q1 = 0, q2 = 0;
+
+	for(uint16_t i = 0; i < count; i++, raw += 6){
+		/* Decode + convert to mg + remove offset */
+		int32_t x = ((int16_t)(raw[0] | (raw[1] << 8)) * scale >> 8) - c->offset[0];
+		int32_t y = ((int16_t)(raw[2] | (raw[3] << 8)) * scale >> 8) - c->offset[1];
+		int32_t z = ((int16_t)(raw[4] | (raw[5] << 8)) * scale >> 8) - c->offset[2];
+		int32_t cx, cy, cz;
+
+		/* Correction matrix */
+		if(diagonal){
+			cx = (x * c->matrix[0][0]) >> 14;
+			cy = (y * c->matrix[1][1]) >> 14;
+			cz = (z * c->matrix[2][2]) >> 14;
+		}
+		else{
+			cx = (x * c->matrix[0][0] + y * c->matrix[0][1] + z * c->matrix[0][2]) >> 14;
+			cy = (x * c->matrix[1][0] + y * c->matrix[1][1] + z * c->matrix[1][2]) >> 14;
+			cz = (x * c->matrix[2][0] + y * c->matrix[2][1] + z * c->matrix[2][2]) >> 14;
+		}
+
+		/* IIR low-pass (state in Q8) */
+		if(!flt->primed){
+			flt->state[0] = cx << 8;
+			flt->state[1] = cy << 8;
+			flt->state[2] = cz << 8;
+			flt->primed = 1;
+		}
+		if(i == 0){
+			f0 = flt->state[0];
+			f1 = flt->state[1];
+			f2 = flt->state[2];
+		}
+		f0 += (int32_t)(((int64_t)((cx << 8) - f0) * ADXL_FILTER_ALPHA) >> 15);
+		f1 += (int32_t)(((int64_t)((cy << 8) - f1) * ADXL_FILTER_ALPHA) >> 15);
+		f2 += (int32_t)(((int64_t)((cz << 8) - f2) * ADXL_FILTER_ALPHA) >> 15);
+
+		int16_t v0 = (int16_t)(f0 >> 8), v1 = (int16_t)(f1 >> 8), v2 = (int16_t)(f2 >> 8);
+		out->samples[i].x = v0;
+		out->samples[i].y = v1;
+		out->samples[i].z = v2;
+
+		/* Window statistics */
+		if(v0 < mn0) mn0 = v0;
+		if(v0 > mx0) mx0 = v0;
+		if(v1 < mn1) mn1 = v1;
+		if(v1 > mx1) mx1 = v1;
+		if(v2 < mn2) mn2 = v2;
+		if(v2 > mx2) mx2 = v2;
+		s0 += v0; s1 += v1; s2 += v2;
+		q0 += (uint64_t)((int32_t)v0 * v0);
+		q1 += (uint64_t)((int32_t)v1 * v1);
+		q2 += (uint64_t)((int32_t)v2 * v2);
+	}
+
+	out->count = count;
+	if(count == 0) return;
+
+	flt->state[0] = f0;
+	flt->state[1] = f1;
+	flt->state[2] = f2;
+
+	adxlStats.min[0] = mn0; adxlStats.min[1] = mn1; adxlStats.min[2] = mn2;
+	adxlStats.max[0] = mx0; adxlStats.max[1] = mx1; adxlStats.max[2] = mx2;
+	adxlStats.sum[0] += s0; adxlStats.sum[1] += s1; adxlStats.sum[2] += s2;
+	adxlStats.sum_sq[0] += q0; adxlStats.sum_sq[1] += q1; adxlStats.sum_sq[2] += q2;
+	adxlStats.count += count;
+}
+
+/**
+ * @brief  Fused decode + convert + calibrate + filter + stats.
+ * @param  raw: FIFO bytes, 6 per sample; may be out->samples itself (in place)
+ * @param  count: Number of samples (<= ADXL_BLOCK_SAMPLES)
+ * @param  out: Destination block; out->data_format selects the scale
+ * @return None
+ * @note   Produces the same result as the staged version
+ *         (convert -> calibrate -> filter -> stats).
+ */
+void adxlFusedKernel(const uint8_t *raw, uint16_t count, ADXL_BlockType *out){
+	const ADXL_CalibType *c = &adxlCalib;
+
+	if(c->matrix[0][1] == 0 && c->matrix[0][2] == 0 && c->matrix[1][0] == 0 &&
+			c->matrix[1][2] == 0 && c->matrix[2][0] == 0 && c->matrix[2][1] == 0){
+		fusedBody(raw, count, out, 1);              //*Common case: offset + gain only
+	}
+	else{
+		fusedBody(raw, count, out, 0);
+	}
+}
+
+/**
+ * @brief  Fused stage: block samples hold raw FIFO data and are processed in place.
+ * @param  block: Pipeline block (after adxlStageAcquire)
+ * @return None
+ * @note   With axes disabled the per-axis stages are used instead, so only
+ *         the enabled axes are processed.
+ */
+void adxlStageFused(ADXL_BlockType *block){
+	if(block->axes_off != 0){
+		adxlStageConvert(block);
+		adxlStageCalibrate(block);
+		adxlStageFilter(block);
+		adxlStageStats(block);
+		return;
+	}
+	adxlFusedKernel((const uint8_t*)block->samples, block->count, block);
+}
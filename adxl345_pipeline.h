@@ -0,0 +1,153 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_pipeline.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Compile-time composed processing pipeline (adxl345_pipeline.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - A pipeline is a list of stage functions 'void stage(ADXL_BlockType *block)'
+ *     expanded by macros into one static function with direct calls:
+ *     no function pointers, no runtime dispatch
+ *   - Each stage declares its block granule; the pipeline block size is checked
+ *     against every granule at compile time
+ *   - adxlStageFused replaces convert + calibrate + filter + stats with one pass
+ *   - Each stage gets a cycle counter (DWT->CYCCNT on the MCU, ns on Linux)
+ *   - Each pipeline owns its IIR filter state; adxlFilter points to it while the
+ *     pipeline runs, so staged and fused runs of one pipeline continue the same
+ *     filter and different pipelines never share one (several devices: one
+ *     pipeline per device)
+ *   - The first stage sees block->count = block size (the requested number of
+ *     samples); a stage that sets block->count to 0 ends the run
+ *
+ *  @usage
+ *   #define VIB_STAGES(X, a)                  \
+ *       X(a, adxlStageAcquire, 1)             \
+ *       X(a, adxlStageConvert, 1)             \
+ *       X(a, adxlStageFilter, 1)              \
+ *       X(a, myFeatures, 8)                   \
+ *       X(a, mySink, 1)
+ *
+ *   ADXL_PIPELINE_DEFINE(vib, 16, VIB_STAGES)
+ *
+ *   adxlCycleInit();
+ *   FIFO_Samples(vib_BLOCK - 1);            // watermark = pipeline block
+ *   ...on WATERMARK: vib_run();
+ *   ...vib_cycles[i] is the total for stage vib_names[i]
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_PIPELINE_H_
+#define INC_ADXL345_PIPELINE_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Cycle counter
+ * --------------------------------------------------*/
+
+#if defined(ADXL_USE_LINUX)
+#include <time.h>
+static inline uint32_t adxlCycles(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#else
+static inline uint32_t adxlCycles(void){
+	return DWT->CYCCNT;
+}
+#endif
+
+void adxlCycleInit(void);
+
+/* --------------------------------------------------
+ * 2. Pipeline definition macros
+ * --------------------------------------------------*/
+
+#define ADXL_PIPE_CHECK_(block_size, fn, granule) \
+	_Static_assert((block_size) % (granule) == 0, "pipeline block size is not a multiple of the " #fn " granule");
+
+#define ADXL_PIPE_NAME_(unused, fn, granule) #fn,
+
+#define ADXL_PIPE_CALL_(name, fn, granule) \
+	t0 = adxlCycles(); \
+	fn(block); \
+	name##_cycles[stage++] += adxlCycles() - t0; \
+	if(block->count == 0) return;
+
+/**
+ * @brief  Defines <name>_run(), <name>_block, <name>_filter, <name>_names[], <name>_cycles[], <name>_BLOCK.
+ * @param  name: Pipeline name
+ * @param  block_size: Samples per run (1 .. ADXL_BLOCK_SAMPLES)
+ * @param  STAGES: X-macro list, STAGES(X, a) -> X(a, function, granule) ...
+ */
+#define ADXL_PIPELINE_DEFINE(name, block_size, STAGES) \
+	STAGES(ADXL_PIPE_CHECK_, block_size) \
+	_Static_assert((block_size) >= 1 && (block_size) <= ADXL_BLOCK_SAMPLES, "pipeline block size out of range"); \
+	enum { name##_BLOCK = (block_size) }; \
+	static ADXL_BlockType name##_block; \
+	static ADXL_FilterType name##_filter; \
+	static const char * const name##_names[] = { STAGES(ADXL_PIPE_NAME_, ~) }; \
+	static uint32_t name##_cycles[sizeof(name##_names) / sizeof(name##_names[0])]; \
+	static inline void name##_run(void){ \
+		ADXL_BlockType *block = &name##_block; \
+		uint32_t t0; \
+		uint8_t stage = 0; \
+		block->count = (block_size); \
+		adxlFilter = &name##_filter; \
+		STAGES(ADXL_PIPE_CALL_, name) \
+		(void)stage; \
+	}
+
+/* --------------------------------------------------
+ * 3. Built-in stages
+ * --------------------------------------------------*/
+
+typedef struct{
+	int16_t min[3];
+	int16_t max[3];
+	int32_t sum[3];
+	uint64_t sum_sq[3];
+	uint32_t count;
+} ADXL_StatsType;
+
+typedef struct{
+	int16_t offset[3];               //*mg, subtracted first
+	int16_t matrix[3][3];            //*Correction matrix, Q14 (16384 = 1.0)
+} ADXL_CalibType;
+
+#define ADXL_CALIB_ONE 16384
+
+typedef struct{
+	int32_t state[3];                //*Filter output per axis, Q8
+	uint8_t primed;                  //*0: next sample seeds the state
+} ADXL_FilterType;
+
+#ifndef ADXL_FILTER_ALPHA
+#define ADXL_FILTER_ALPHA 8192       //*IIR low-pass coefficient, Q15 (0.25)
+#endif
+
+void adxlStageAcquire(ADXL_BlockType *block);
+void adxlStageConvert(ADXL_BlockType *block);
+void adxlStageFilter(ADXL_BlockType *block);
+void adxlStageStats(ADXL_BlockType *block);
+void adxlStageCalibrate(ADXL_BlockType *block);
+
+void adxlFusedKernel(const uint8_t *raw, uint16_t count, ADXL_BlockType *out);
+void adxlStageFused(ADXL_BlockType *block);
+
+void adxlStatsReset(ADXL_StatsType *stats);
+void adxlFilterReset(ADXL_FilterType *filter);
+extern ADXL_FilterType *adxlFilter;
+extern ADXL_StatsType adxlStats;
+extern ADXL_CalibType adxlCalib;
+
+#endif /* INC_ADXL345_PIPELINE_H_ */
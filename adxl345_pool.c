@@ -0,0 +1,95 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_pool.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Static sample-block pool with reference counting (adxl345_pool.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Free blocks are tracked in a 32-bit mask updated with compare-and-swap,
+ *     so there is no free-list ABA problem and no interrupt masking.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_pool.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+_Static_assert(ADXL_POOL_BLOCKS >= 1 && ADXL_POOL_BLOCKS <= 32, "ADXL_POOL_BLOCKS must be 1 .. 32");
+
+#define POOL_ALL ((ADXL_POOL_BLOCKS == 32) ? 0xFFFFFFFFU : ((1U << ADXL_POOL_BLOCKS) - 1U))
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+typedef struct{
+	_Alignas(ADXL_POOL_ALIGN) ADXL_BlockType block;
+} PoolSlotType;
+
+static PoolSlotType pool[ADXL_POOL_BLOCKS];
+static _Atomic uint8_t refs[ADXL_POOL_BLOCKS];
+static _Atomic uint32_t free_mask = POOL_ALL;
+
+/**
+ * @brief  Converts a block pointer back to its pool index.
+ */
+static uint32_t poolIndex(const ADXL_BlockType *block){
+	return (uint32_t)((const PoolSlotType*)(const void*)block - pool);
+}
+
+/* --------------------------------------------------
+ * Pool Functions
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Takes a free block from the pool.
+ * @return Block with one reference, or NULL if the pool is exhausted
+ */
+ADXL_BlockType *adxlPoolAlloc(void){
+	uint32_t mask = atomic_load_explicit(&free_mask, memory_order_relaxed);
+	uint32_t bit;
+
+	do{
+		if(mask == 0) return NULL;
+		bit = mask & (~mask + 1U);                   //*Lowest free block
+	}while(!atomic_compare_exchange_weak_explicit(&free_mask, &mask, mask & ~bit,
+			memory_order_acquire, memory_order_relaxed));
+
+	uint32_t i = (uint32_t)__builtin_ctz(bit);
+	atomic_store_explicit(&refs[i], 1, memory_order_relaxed);
+	pool[i].block.count = 0;
+	return &pool[i].block;
+}
+
+/**
+ * @brief  Adds a reference for another stage.
+ * @param  block: Block from adxlPoolAlloc()
+ * @return None
+ */
+void adxlPoolRetain(ADXL_BlockType *block){
+	atomic_fetch_add_explicit(&refs[poolIndex(block)], 1, memory_order_relaxed);
+}
+
+/**
+ * @brief  Drops a reference; the last one returns the block to the pool.
+ * @param  block: Block from adxlPoolAlloc()
+ * @return None
+ */
+void adxlPoolRelease(ADXL_BlockType *block){
+	uint32_t i = poolIndex(block);
+
+	if(atomic_fetch_sub_explicit(&refs[i], 1, memory_order_acq_rel) == 1){
+		atomic_fetch_or_explicit(&free_mask, 1U << i, memory_order_release);
+	}
+}
+
+/**
+ * @brief  Number of free blocks.
+ * @return Free block count
+ */
+uint8_t adxlPoolAvailable(void){
+	return (uint8_t)__builtin_popcount(atomic_load_explicit(&free_mask, memory_order_relaxed));
+}
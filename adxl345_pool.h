@@ -0,0 +1,59 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_pool.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Static sample-block pool with reference counting (adxl345_pool.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - ADXL_POOL_BLOCKS blocks are allocated at compile time; no heap is used
+ *   - A block handle is the ADXL_BlockType pointer itself: stages share it
+ *     instead of copying the samples
+ *   - Every stage that keeps the block calls adxlPoolRetain(); every stage that
+ *     is done with it calls adxlPoolRelease(). The last release returns it
+ *   - Alloc/retain/release are lock-free and may be called from interrupts
+ *
+ *  @usage
+ *   ADXL_BlockType *b = adxlPoolAlloc();      // refs = 1 (acquisition)
+ *   drainFifo(b);
+ *   adxlPoolRetain(b); recorderPush(b);       // recorder releases when written
+ *   adxlPoolRetain(b); uplinkPush(b);         // uplink releases when sent
+ *   filterRun(b);
+ *   adxlPoolRelease(b);                       // acquisition reference
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_POOL_H_
+#define INC_ADXL345_POOL_H_
+
+#include "adxl345_types.h"
+
+/* --------------------------------------------------
+ * 1. Pool setting value define
+ * --------------------------------------------------*/
+
+#ifndef ADXL_POOL_BLOCKS
+#define ADXL_POOL_BLOCKS 8           //*1 .. 32
+#endif
+
+#ifndef ADXL_POOL_ALIGN
+#define ADXL_POOL_ALIGN 32           //*Block alignment (DMA / cache line)
+#endif
+
+/* --------------------------------------------------
+ * 2. function define
+ * --------------------------------------------------*/
+
+ADXL_BlockType *adxlPoolAlloc(void);
+void adxlPoolRetain(ADXL_BlockType *block);
+void adxlPoolRelease(ADXL_BlockType *block);
+uint8_t adxlPoolAvailable(void);
+
+#endif /* INC_ADXL345_POOL_H_ */
@@ -0,0 +1,181 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_power.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Auto-sleep and link-mode engine in physical units (adxl345_power.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - THRESH_ACT, THRESH_INACT, TIME_INACT and ACT_INACT_CTL (0x24 .. 0x27) are
+ *     written in one burst.
+ *   - Datasheet (POWER_CTL): clearing SLEEP or AUTO_SLEEP should go through
+ *     standby, then measurement with a second write. Auto-sleep only works
+ *     with the link bit set.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_power.h"
+
+/**
+ * @brief  Converts a threshold in mg to THRESH_ACT / THRESH_INACT units.
+ * @param  mg: Threshold in mg
+ * @return Register value (rounded, 1 .. 255)
+ * @note   0 would make every sample active/inactive, so the minimum is 1 LSB.
+ */
+uint8_t adxlPowerMgToThresh(uint16_t mg){
+	uint32_t lsb = ((uint32_t)mg * 10U + ADXL_ACT_MG_PER_LSB_X10 / 2) / ADXL_ACT_MG_PER_LSB_X10;
+
+	if(lsb < 1) lsb = 1;
+	if(lsb > 255) lsb = 255;
+	return (uint8_t)lsb;
+}
+
+/**
+ * @brief  Records a state transition.
+ */
+static void powerSetState(ADXL_PowerType *power, uint8_t state, uint32_t now_ms){
+	if(power->state == state) return;
+
+	if(state == ADXL_POWER_ASLEEP){
+		power->sleeps++;
+	}
+	else{
+		power->wakes++;
+		power->asleep_ms += now_ms - power->since_ms;
+	}
+	power->state = state;
+	power->since_ms = now_ms;
+	if(power->on_change != NULL) power->on_change(state, now_ms);
+}
+
+/**
+ * @brief  Writes POWER_CTL, through standby if the sensor is measuring.
+ * @return ADXL_OK, or ADXL_ERROR on bus failure
+ */
+static uint8_t powerWriteCtl(uint8_t value){
+	uint8_t current = getShadow()[POWER_CTL - ADXL_SHADOW_FIRST];
+	uint8_t standby = value & (uint8_t)~MEASURE_ON;
+
+	if(current == value) return ADXL_OK;
+	if(current & MEASURE_ON){
+		if(writeBurst(POWER_CTL, &standby, 1) != ADXL_OK) return ADXL_ERROR;
+		if(value == standby) return ADXL_OK;
+	}
+	return writeBurst(POWER_CTL, &value, 1);
+}
+
+/**
+ * @brief  Initializes a power-state context (awake, counters cleared).
+ * @param  power: Pointer to ADXL_PowerType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return None
+ * @note   on_change may be set after this call.
+ */
+void adxlPowerInit(ADXL_PowerType *power, uint32_t now_ms){
+	*power = (ADXL_PowerType){0};
+	power->state = ADXL_POWER_AWAKE;
+	power->since_ms = now_ms;
+}
+
+/**
+ * @brief  Applies an auto-sleep / link-mode configuration.
+ * @param  power: Pointer to ADXL_PowerType structure (initialized with adxlPowerInit())
+ * @param  config: Configuration in physical units
+ * @return ADXL_OK, or ADXL_ERROR on bus failure
+ * @note   Keeps the MEASURE bit as it is; enables link mode when auto-sleep is set.
+ */
+uint8_t adxlPowerConfigure(ADXL_PowerType *power, const ADXL_PowerConfigType *config){
+	const uint8_t *shadow = getShadow();
+	uint8_t regs[4];
+	uint8_t power_ctl;
+
+	power->config = *config;
+	if(config->autosleep == AUTOSLEEPMODE_ON) power->config.link = LINKMODE_ON;
+
+	/* 0x24 .. 0x27 in one burst */
+	regs[0] = adxlPowerMgToThresh(config->act_mg);
+	regs[1] = adxlPowerMgToThresh(config->inact_mg);
+	regs[2] = config->inact_s;
+	regs[3] = (uint8_t)(((config->act_axes & ADXL_AXIS_ALL) << ACT_AXES_SHIFT) |
+			((config->inact_axes & ADXL_AXIS_ALL) << INACT_AXES_SHIFT) |
+			(config->act_ac ? ACT_AC_COUPLED : 0) | (config->inact_ac ? INACT_AC_COUPLED : 0));
+	if(writeBurst(THRESH_ACT, regs, 4) != ADXL_OK) return ADXL_ERROR;
+
+	if(config->interrupts){
+		uint8_t int_enable = shadow[INT_ENABLE - ADXL_SHADOW_FIRST] | ACTIVITY_ON | INACTIVITY_ON;
+		if(writeBurst(INT_ENABLE, &int_enable, 1) != ADXL_OK) return ADXL_ERROR;
+	}
+
+	/* Link/auto-sleep/wake-up change in standby, measurement resumes last */
+	power_ctl = (uint8_t)((shadow[POWER_CTL - ADXL_SHADOW_FIRST] & MEASURE_ON) |
+			power->config.link | power->config.autosleep | (config->wakeup & 0x03));
+	if(powerWriteCtl(power_ctl) != ADXL_OK) return ADXL_ERROR;
+
+	markConfigChange();
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Puts the sensor to sleep now (samples at the wake-up rate).
+ * @param  power: Pointer to ADXL_PowerType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return ADXL_OK, or ADXL_ERROR on bus failure (state unchanged)
+ */
+uint8_t adxlPowerSleep(ADXL_PowerType *power, uint32_t now_ms){
+	uint8_t power_ctl = getShadow()[POWER_CTL - ADXL_SHADOW_FIRST] | SLEEPMODE_ON;
+
+	if(writeBurst(POWER_CTL, &power_ctl, 1) != ADXL_OK) return ADXL_ERROR;
+	powerSetState(power, ADXL_POWER_ASLEEP, now_ms);
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Wakes the sensor (clears SLEEP through standby, as the datasheet asks).
+ * @param  power: Pointer to ADXL_PowerType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return ADXL_OK, or ADXL_ERROR on bus failure (state unchanged)
+ */
+uint8_t adxlPowerWake(ADXL_PowerType *power, uint32_t now_ms){
+	uint8_t power_ctl = getShadow()[POWER_CTL - ADXL_SHADOW_FIRST] & (uint8_t)~SLEEPMODE_ON;
+	uint8_t standby = power_ctl & (uint8_t)~MEASURE_ON;
+
+	if(writeBurst(POWER_CTL, &standby, 1) != ADXL_OK) return ADXL_ERROR;
+	if(power_ctl != standby && writeBurst(POWER_CTL, &power_ctl, 1) != ADXL_OK) return ADXL_ERROR;
+	powerSetState(power, ADXL_POWER_AWAKE, now_ms);
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Updates the state from an INT_SOURCE value read by the application.
+ * @param  power: Pointer to ADXL_PowerType structure
+ * @param  int_source: INT_SOURCE register value
+ * @param  now_ms: Current time in milliseconds
+ * @return None
+ * @note   Only meaningful with auto-sleep: without it, inactivity does not sleep.
+ */
+void adxlPowerOnInterrupt(ADXL_PowerType *power, uint8_t int_source, uint32_t now_ms){
+	if(power->config.autosleep != AUTOSLEEPMODE_ON) return;
+
+	/* With link mode only one of the two is armed at a time */
+	if(int_source & INACTIVITY_INT) powerSetState(power, ADXL_POWER_ASLEEP, now_ms);
+	if(int_source & ACTIVITY_INT) powerSetState(power, ADXL_POWER_AWAKE, now_ms);
+}
+
+/**
+ * @brief  Reads the Asleep bit of ACT_TAP_STATUS and updates the state.
+ * @param  power: Pointer to ADXL_PowerType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return ADXL_POWER_AWAKE or ADXL_POWER_ASLEEP
+ * @note   Does not read INT_SOURCE, so no interrupt is consumed.
+ */
+uint8_t adxlPowerPoll(ADXL_PowerType *power, uint32_t now_ms){
+	uint8_t status;
+
+	if(readBurst(ACT_TAP_STATUS, &status, 1) == ADXL_OK){
+		powerSetState(power, (status & ASLEEP_STATUS) ? ADXL_POWER_ASLEEP : ADXL_POWER_AWAKE, now_ms);
+	}
+	return power->state;
+}
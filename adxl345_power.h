@@ -0,0 +1,99 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_power.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Auto-sleep and link-mode engine in physical units (adxl345_power.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Thresholds in mg (62.5 mg/LSB), inactivity time in seconds (1 s/LSB)
+ *   - Activity / inactivity axes and AC/DC coupling (the ADXL345 selects
+ *     coupling per function, axes per axis)
+ *   - Wake-up rate, link mode and auto-sleep, applied with the datasheet
+ *     sequence: configure in standby, measure last; leaving sleep goes
+ *     through standby so the first samples are not noisy
+ *   - The sleep state is tracked from INT_SOURCE (ACTIVITY / INACTIVITY)
+ *     or read from ACT_TAP_STATUS (Asleep bit)
+ *   - The sensor does the motion gating: in auto-sleep it samples at the
+ *     wake-up rate until activity, and the MCU only wakes on the interrupt
+ *
+ *  @usage
+ *   ADXL_PowerType power;
+ *   ADXL_PowerConfigType cfg = ADXL_POWER_DEFAULT;
+ *   adxlPowerInit(&power, HAL_GetTick());
+ *   cfg.act_mg = 300;  cfg.inact_mg = 100;  cfg.inact_s = 30;  cfg.act_ac = 1;
+ *   adxlPowerConfigure(&power, &cfg);
+ *   EXTI:  adxlPowerPoll(&power, HAL_GetTick());
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_POWER_H_
+#define INC_ADXL345_POWER_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Power setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_ACT_MG_PER_LSB_X10 625     //*62.5 mg/LSB
+
+#define ADXL_POWER_AWAKE 0
+#define ADXL_POWER_ASLEEP 1
+
+/** Thresholds and coupling of configureAutosleep() (1 g / 250 mg / 5 s, all axes, AC),
+ *  with link mode and auto-sleep on and INT_ENABLE left alone, as adxlInit() does */
+#define ADXL_POWER_DEFAULT { \
+	.act_mg = 1000, .inact_mg = 250, .inact_s = 5, \
+	.act_axes = ADXL_AXIS_ALL, .inact_axes = ADXL_AXIS_ALL, .act_ac = 1, .inact_ac = 1, \
+	.wakeup = WAKEUP_8Hz, .link = LINKMODE_ON, .autosleep = AUTOSLEEPMODE_ON, \
+	.interrupts = 0 }
+
+/* --------------------------------------------------
+ * 2. Power Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint16_t act_mg;                 //*Activity threshold (62.5 .. 15937 mg)
+	uint16_t inact_mg;               //*Inactivity threshold
+	uint8_t inact_s;                 //*Inactivity time before sleep (0 .. 255 s)
+	uint8_t act_axes;                //*ADXL_AXIS_X | ADXL_AXIS_Y | ADXL_AXIS_Z
+	uint8_t inact_axes;
+	uint8_t act_ac;                  //*1: AC-coupled (change from the reference at activity start)
+	uint8_t inact_ac;
+	uint8_t wakeup;                  //*WAKEUP_8Hz .. WAKEUP_1Hz (sampling rate in sleep)
+	uint8_t link;                    //*LINKMODE_ON: activity and inactivity alternate
+	uint8_t autosleep;               //*AUTOSLEEPMODE_ON: sleep on inactivity (forces link)
+	uint8_t interrupts;              //*1: enable ACTIVITY / INACTIVITY in INT_ENABLE
+} ADXL_PowerConfigType;
+
+typedef struct{
+	ADXL_PowerConfigType config;
+	uint8_t state;                   //*ADXL_POWER_AWAKE / ADXL_POWER_ASLEEP
+	uint32_t since_ms;               //*Time of the last transition
+	uint32_t sleeps;
+	uint32_t wakes;
+	uint32_t asleep_ms;              //*Total time asleep (completed intervals)
+	void (*on_change)(uint8_t state, uint32_t now_ms);
+} ADXL_PowerType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlPowerInit(ADXL_PowerType *power, uint32_t now_ms);
+uint8_t adxlPowerConfigure(ADXL_PowerType *power, const ADXL_PowerConfigType *config);
+uint8_t adxlPowerSleep(ADXL_PowerType *power, uint32_t now_ms);
+uint8_t adxlPowerWake(ADXL_PowerType *power, uint32_t now_ms);
+void adxlPowerOnInterrupt(ADXL_PowerType *power, uint8_t int_source, uint32_t now_ms);
+uint8_t adxlPowerPoll(ADXL_PowerType *power, uint32_t now_ms);
+uint8_t adxlPowerMgToThresh(uint16_t mg);
+
+#endif /* INC_ADXL345_POWER_H_ */
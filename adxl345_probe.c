@@ -0,0 +1,331 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_probe.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Bus discovery and device handles (adxl345_probe.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - MCU: the I2C reads use HAL_I2C_Mem_Read_IT and are polled with
+ *     HAL_I2C_GetState(), so the I2C event/error interrupts must be enabled;
+ *     no callback forwarding is needed. A read still running after TIMEOUT is
+ *     aborted (the peripheral is reinitialized if the abort fails). SPI chip
+ *     selects are read one after the other (a few microseconds each).
+ *   - Linux: each thread opens its own descriptor and talks ioctl directly,
+ *     so the shared transport is not touched until the handles exist.
+ *     Devices on one i2c-dev adapter share its descriptor. There is one
+ *     simulator: its requests are serialized and only the first NULL bus
+ *     is probed.
+ *   - Handles are listed in bus order, 0x53 before 0x1D, whatever order the
+ *     buses finished in.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_probe.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(ADXL_USE_LINUX)
+#include "adxl345_sim.h"
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
+#endif
+
+static const uint8_t probe_address[2] = { 0x53, ADXL_I2C_ADDRESS_ALT };
+
+/**
+ * @brief  Adds a handle, initialized with adxlInit() if requested.
+ * @return New count
+ */
+static uint8_t probeAdd(ADXL_DeviceType *devices, uint8_t count, const ADXL_DeviceType *found, ADXL_InitType *init){
+	ADXL_DeviceType *dev = &devices[count];
+
+	*dev = *found;
+	adxlDeviceReset(dev);
+
+	if(init != NULL && adxlSelect(dev) == ADXL_OK) adxlInit(init);
+	return (uint8_t)(count + 1);
+}
+
+#if defined(ADXL_USE_LINUX)
+/* --------------------------------------------------
+ * Linux: one thread per bus
+ * --------------------------------------------------*/
+
+typedef struct{
+	const ADXL_ProbeBusType *bus;
+	int fd;
+	uint8_t sim;
+	uint8_t found[2];                //*Per address (I2C) / [0] for SPI
+} ProbeWorkType;
+
+static pthread_mutex_t probe_sim_lock = PTHREAD_MUTEX_INITIALIZER;     //*adxlSim is global
+
+static int probeIoctl(const ProbeWorkType *work, unsigned long request, void *arg){
+	int ret;
+
+	if(!work->sim) return ioctl(work->fd, request, arg);
+
+	pthread_mutex_lock(&probe_sim_lock);
+	ret = adxlSimIoctl(work->fd, request, arg);
+	pthread_mutex_unlock(&probe_sim_lock);
+	return ret;
+}
+
+/**
+ * @brief  Reads DEVID at one I2C address or over SPI.
+ */
+static uint8_t probeDevId(const ProbeWorkType *work, uint8_t address){
+	uint8_t reg = DEVID;
+	uint8_t id = 0;
+
+	if(work->bus->spi){
+		uint8_t tx[2] = { 0x80 | DEVID, 0 }, rx[2] = { 0, 0 };
+		struct spi_ioc_transfer xfer = {0};
+		xfer.tx_buf = (uintptr_t)tx;
+		xfer.rx_buf = (uintptr_t)rx;
+		xfer.len = 2;
+		if(probeIoctl(work, SPI_IOC_MESSAGE(1), &xfer) < 0) return 0;
+		return rx[1];
+	}
+	else{
+		struct i2c_msg msg[2] = {
+			{ address, 0, 1, &reg },
+			{ address, I2C_M_RD, 1, &id }
+		};
+		struct i2c_rdwr_ioctl_data rdwr = { msg, 2 };
+		if(probeIoctl(work, I2C_RDWR, &rdwr) < 0) return 0;
+		return id;
+	}
+}
+
+static void *probeWorker(void *arg){
+	ProbeWorkType *work = arg;
+	const ADXL_ProbeBusType *bus = work->bus;
+
+	work->sim = (uint8_t)(bus->path == NULL);
+	work->fd = work->sim ? adxlSimOpen() : open(bus->path, O_RDWR);
+	if(work->fd < 0) return NULL;
+
+	if(bus->spi){
+		uint8_t mode = ADXL_SPI_MODE, bits = 8;
+		uint32_t speed = (bus->speed_hz != 0) ? bus->speed_hz : 5000000U;
+		if(probeIoctl(work, SPI_IOC_WR_MODE, &mode) < 0 || probeIoctl(work, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+				probeIoctl(work, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) return NULL;
+		work->found[0] = (uint8_t)(probeDevId(work, 0) == ADXL_DEVID_VALUE);
+		return NULL;
+	}
+
+	for(uint8_t k = 0; k < 2; k++) work->found[k] = (uint8_t)(probeDevId(work, probe_address[k]) == ADXL_DEVID_VALUE);
+	return NULL;
+}
+
+/**
+ * @brief  Probes every bus and creates a handle per ADXL345 found.
+ * @param  buses: Bus table
+ * @param  count: Number of buses (<= ADXL_PROBE_MAX_BUSES)
+ * @param  devices: Handles to fill
+ * @param  max: Capacity of devices
+ * @param  init: Configuration applied to every device found (NULL: none)
+ * @return Number of devices found
+ * @note   The previously selected device is selected again on return.
+ */
+uint8_t adxlProbe(const ADXL_ProbeBusType *buses, uint8_t count, ADXL_DeviceType *devices, uint8_t max, ADXL_InitType *init){
+	ProbeWorkType work[ADXL_PROBE_MAX_BUSES];
+	pthread_t tid[ADXL_PROBE_MAX_BUSES];
+	uint8_t started[ADXL_PROBE_MAX_BUSES] = {0};
+	ADXL_DeviceType *previous = adxlSelected();
+	uint8_t n = 0, sim = 0;
+
+	if(count > ADXL_PROBE_MAX_BUSES) count = ADXL_PROBE_MAX_BUSES;
+
+	for(uint8_t b = 0; b < count; b++){
+		work[b] = (ProbeWorkType){ .bus = &buses[b], .fd = -1 };
+		if(buses[b].path == NULL && sim++){
+			printf("Error: Bus %u is a second simulator bus (skipped)\r\n", b);
+			continue;
+		}
+		started[b] = (uint8_t)(pthread_create(&tid[b], NULL, probeWorker, &work[b]) == 0);
+		if(!started[b]) probeWorker(&work[b]);
+	}
+	for(uint8_t b = 0; b < count; b++){
+		if(started[b]) pthread_join(tid[b], NULL);
+	}
+
+	for(uint8_t b = 0; b < count; b++){
+		uint8_t used = 0;
+
+		for(uint8_t k = 0; k < (buses[b].spi ? 1 : 2); k++){
+			if(!work[b].found[k]) continue;
+			if(n == max){
+				printf("Error: More ADXL345 devices than handles\r\n");
+				break;
+			}
+
+			ADXL_DeviceType found = {0};
+			found.bus = buses[b].spi ? ADXL_BUS_SPI : ADXL_BUS_I2C;
+			found.address = buses[b].spi ? 0 : probe_address[k];
+			found.devid = ADXL_DEVID_VALUE;
+			found.bus_index = b;
+			found.fd = work[b].fd;
+			found.sim = work[b].sim;
+			n = probeAdd(devices, n, &found, init);
+			used = 1;
+		}
+		if(!used && work[b].fd >= 0) close(work[b].fd);
+	}
+
+	adxlSelect(previous);
+	return n;
+}
+
+/**
+ * @brief  Releases handles from adxlProbe() (closes their descriptors).
+ * @param  devices: Handles
+ * @param  count: Number of handles
+ * @return None
+ * @note   Selects the default device if one of the handles is selected.
+ */
+void adxlProbeRelease(ADXL_DeviceType *devices, uint8_t count){
+	for(uint8_t i = 0; i < count; i++){
+		if(adxlSelected() == &devices[i]) adxlSelect(NULL);
+	}
+	for(uint8_t i = 0; i < count; i++){
+		uint8_t shared = 0;
+		for(uint8_t j = 0; j < i; j++) shared |= (uint8_t)(devices[j].fd == devices[i].fd);
+		if(!shared && devices[i].fd >= 0) close(devices[i].fd);
+	}
+}
+
+#else
+/* --------------------------------------------------
+ * MCU: interrupt-driven reads on all I2C buses at once
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Ends a DEVID read that did not finish within TIMEOUT (bus held, lost
+ *         interrupt), so the next probe and the driver find the bus ready.
+ * @note   Falls back to reinitializing the peripheral when the HAL refuses the
+ *         abort (memory-mode transfers on some families) or it does not complete.
+ */
+static void probeAbort(I2C_HandleTypeDef *i2c, uint8_t address){
+	uint32_t t0 = HAL_GetTick();
+
+	if(HAL_I2C_Master_Abort_IT(i2c, (uint16_t)(address << 1)) == HAL_OK){
+		while(HAL_I2C_GetState(i2c) != HAL_I2C_STATE_READY && HAL_GetTick() - t0 < TIMEOUT);
+	}
+	if(HAL_I2C_GetState(i2c) != HAL_I2C_STATE_READY){
+		HAL_I2C_DeInit(i2c);
+		HAL_I2C_Init(i2c);
+	}
+}
+
+/**
+ * @brief  Probes every bus and creates a handle per ADXL345 found.
+ * @param  buses: Bus table
+ * @param  count: Number of buses (<= ADXL_PROBE_MAX_BUSES)
+ * @param  devices: Handles to fill
+ * @param  max: Capacity of devices
+ * @param  init: Configuration applied to every device found (NULL: none)
+ * @return Number of devices found (0 while a driver DMA/IT transfer is in flight)
+ * @note   The previously selected device is selected again on return.
+ */
+uint8_t adxlProbe(const ADXL_ProbeBusType *buses, uint8_t count, ADXL_DeviceType *devices, uint8_t max, ADXL_InitType *init){
+	uint8_t id[ADXL_PROBE_MAX_BUSES][2];
+	uint8_t started[ADXL_PROBE_MAX_BUSES][2];
+	ADXL_DeviceType *previous = adxlSelected();
+	uint8_t n = 0;
+
+	if(adxlBusy()) return 0;
+	if(count > ADXL_PROBE_MAX_BUSES) count = ADXL_PROBE_MAX_BUSES;
+	memset(id, 0, sizeof(id));
+	memset(started, 0, sizeof(started));
+
+	/* Same address on every I2C bus at once, then the alternate address */
+	for(uint8_t k = 0; k < 2; k++){
+		uint32_t t0 = HAL_GetTick();
+		uint8_t pending;
+
+		for(uint8_t b = 0; b < count; b++){
+			if(buses[b].i2c == NULL) continue;
+			started[b][k] = (uint8_t)(HAL_I2C_Mem_Read_IT(buses[b].i2c, (uint16_t)(probe_address[k] << 1), DEVID,
+					I2C_MEMADD_SIZE_8BIT, &id[b][k], 1) == HAL_OK);
+		}
+		do{
+			pending = 0;
+			for(uint8_t b = 0; b < count; b++){
+				if(started[b][k] && HAL_I2C_GetState(buses[b].i2c) != HAL_I2C_STATE_READY) pending = 1;
+			}
+		} while(pending && HAL_GetTick() - t0 < TIMEOUT);
+
+		for(uint8_t b = 0; b < count; b++){
+			if(!started[b][k]) continue;
+			if(HAL_I2C_GetState(buses[b].i2c) != HAL_I2C_STATE_READY){
+				probeAbort(buses[b].i2c, probe_address[k]);
+				id[b][k] = 0;
+			}
+			else if(HAL_I2C_GetError(buses[b].i2c) != HAL_I2C_ERROR_NONE) id[b][k] = 0;
+		}
+	}
+
+	for(uint8_t b = 0; b < count; b++){
+		ADXL_DeviceType found = {0};
+		found.bus_index = b;
+		found.devid = ADXL_DEVID_VALUE;
+
+		if(buses[b].i2c != NULL){
+			found.bus = ADXL_BUS_I2C;
+			found.i2c = buses[b].i2c;
+			for(uint8_t k = 0; k < 2 && n < max; k++){
+				if(id[b][k] != ADXL_DEVID_VALUE) continue;
+				found.address = probe_address[k];
+				n = probeAdd(devices, n, &found, init);
+			}
+			continue;
+		}
+
+#if defined(HAL_SPI_MODULE_ENABLED)
+		found.bus = ADXL_BUS_SPI;
+		found.spi = buses[b].spi;
+		for(uint8_t c = 0; c < buses[b].cs_count && c < ADXL_PROBE_MAX_CS && n < max; c++){
+			uint8_t tx = 0x80 | DEVID, devid = 0;
+			HAL_StatusTypeDef status;
+
+			HAL_GPIO_WritePin(buses[b].cs_port[c], buses[b].cs_pin[c], GPIO_PIN_RESET);
+			status = HAL_SPI_Transmit(buses[b].spi, &tx, 1, TIMEOUT);
+			if(status == HAL_OK) status = HAL_SPI_Receive(buses[b].spi, &devid, 1, TIMEOUT);
+			HAL_GPIO_WritePin(buses[b].cs_port[c], buses[b].cs_pin[c], GPIO_PIN_SET);
+			if(status != HAL_OK || devid != ADXL_DEVID_VALUE) continue;
+
+			found.cs_port = buses[b].cs_port[c];
+			found.cs_pin = buses[b].cs_pin[c];
+			n = probeAdd(devices, n, &found, init);
+		}
+#endif
+	}
+
+	adxlSelect(previous);
+	return n;
+}
+
+/**
+ * @brief  Releases handles from adxlProbe().
+ * @param  devices: Handles
+ * @param  count: Number of handles
+ * @return None
+ * @note   Selects the default device if one of the handles is selected.
+ */
+void adxlProbeRelease(ADXL_DeviceType *devices, uint8_t count){
+	for(uint8_t i = 0; i < count; i++){
+		if(adxlSelected() == &devices[i]) adxlSelect(NULL);
+	}
+}
+#endif
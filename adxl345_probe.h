@@ -0,0 +1,79 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_probe.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Bus discovery and device handles (adxl345_probe.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Scans every configured bus: I2C at 0x53 and 0x1D, SPI at each chip select
+ *   - A device counts only if DEVID reads 0xE5 (no ACK, a floating MISO or
+ *     another part at the address is skipped)
+ *   - Fills ADXL_DeviceType handles, optionally configured with adxlInit();
+ *     adxlSelect() then points the whole driver at one of them
+ *   - Per device: shadow, axis mask, sequence numbers, readLatest() cell and the
+ *     glitch/health stage state (dev.glitch / dev.health); use one pipeline per
+ *     device for the filter state
+ *   - Buses are probed in parallel: interrupt-driven reads on every I2C bus
+ *     at once (MCU), one thread per bus (Linux)
+ *
+ *  @usage
+ *   ADXL_ProbeBusType buses[] = { { .i2c = &hi2c1 }, { .i2c = &hi2c2 },
+ *       { .spi = &hspi1, .cs_port = { GPIOA, GPIOB }, .cs_pin = { GPIO_PIN_4, GPIO_PIN_0 }, .cs_count = 2 } };
+ *   ADXL_DeviceType dev[8];
+ *   uint8_t n = adxlProbe(buses, 3, dev, 8, &Config);
+ *   for(i = 0; i < n; i++){ adxlSelect(&dev[i]); readAccel(); ... }
+ *
+ *   Linux: ADXL_ProbeBusType buses[] = { { "/dev/i2c-1" }, { "/dev/spidev0.0", 1, 5000000 } };
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_PROBE_H_
+#define INC_ADXL345_PROBE_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Probe setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_PROBE_MAX_BUSES 8
+#define ADXL_PROBE_MAX_CS 4          //*Chip selects per SPI bus (MCU)
+
+/* --------------------------------------------------
+ * 2. Probe Typedef
+ * --------------------------------------------------*/
+
+#if defined(ADXL_USE_LINUX)
+typedef struct{
+	const char *path;                //*"/dev/i2c-N" or "/dev/spidevB.C"; NULL: simulator
+	uint8_t spi;                     //*1: spidev (one chip select per node)
+	uint32_t speed_hz;               //*SPI clock (0: 5 MHz)
+} ADXL_ProbeBusType;
+#else
+typedef struct{
+	I2C_HandleTypeDef *i2c;          //*I2C bus, or NULL for an SPI bus
+#if defined(HAL_SPI_MODULE_ENABLED)
+	SPI_HandleTypeDef *spi;          //*Mode 3, <= 5 MHz
+	GPIO_TypeDef *cs_port[ADXL_PROBE_MAX_CS];
+	uint16_t cs_pin[ADXL_PROBE_MAX_CS];
+	uint8_t cs_count;
+#endif
+} ADXL_ProbeBusType;
+#endif
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+uint8_t adxlProbe(const ADXL_ProbeBusType *buses, uint8_t count, ADXL_DeviceType *devices, uint8_t max, ADXL_InitType *init);
+void adxlProbeRelease(ADXL_DeviceType *devices, uint8_t count);
+
+#endif /* INC_ADXL345_PROBE_H_ */
@@ -0,0 +1,218 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_profile.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Named configuration profiles with burst switching (adxl345_profile.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - POWER_CTL is never part of a burst: it is the pause/resume switch and is
+ *     written once, last.
+ *   - Switch cost can be measured in the simulator (adxlSim.transactions, adxlSim.bus_us).
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_profile.h"
+#include <string.h>
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+static const ADXL_ProfileType *profile_table = NULL;
+static uint8_t profile_count = 0;
+static uint8_t profile_current = ADXL_PROFILE_NONE;
+static ADXL_BurstPlanType profile_plan[ADXL_PROFILE_MAX][ADXL_PROFILE_MAX];
+
+/**
+ * @brief  Registers that can be part of a burst (writable, not POWER_CTL).
+ */
+static uint8_t burstable(uint8_t reg){
+	if(reg == ACT_TAP_STATUS || reg == INT_SOURCE || reg == POWER_CTL) return 0;
+	if(reg >= DATAX0 && reg <= DATAZ1) return 0;
+	return 1;
+}
+
+/* --------------------------------------------------
+ * Planning
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Builds the burst plan that turns register image 'from' into 'to'.
+ * @param  from: Current image (ADXL_SHADOW_SIZE bytes)
+ * @param  to: Target image
+ * @param  plan: Resulting plan
+ * @return None
+ * @note   Runs of changed registers closer than ADXL_PROFILE_BRIDGE unchanged
+ *         ones are merged: rewriting a byte is cheaper than a new transaction.
+ */
+void adxlProfilePlan(const uint8_t *from, const uint8_t *to, ADXL_BurstPlanType *plan){
+	ADXL_BurstType *open = NULL;
+	uint8_t gap = 0;
+
+	plan->count = 0;
+	plan->power_ctl = (from[ADXL_REG(POWER_CTL)] != to[ADXL_REG(POWER_CTL)]);
+	plan->pause = 0;
+
+	for(uint8_t reg = ADXL_SHADOW_FIRST; reg <= ADXL_SHADOW_LAST; reg++){
+		uint8_t i = ADXL_REG(reg);
+
+		if(!burstable(reg)){
+			open = NULL;                           //*Bursts cannot cross this register
+			continue;
+		}
+
+		if(from[i] == to[i]){
+			if(open != NULL && ++gap > ADXL_PROFILE_BRIDGE) open = NULL;
+			continue;
+		}
+
+		if(reg == BW_RATE || reg == DATA_FORMAT || reg == FIFO_CTL) plan->pause = 1;
+
+		if(open != NULL){
+			open->len = (uint8_t)(reg - open->reg + 1);  //*Extend, bridging the gap
+		}
+		else if(plan->count < ADXL_PROFILE_MAX_BURSTS){
+			open = &plan->burst[plan->count++];
+			open->reg = reg;
+			open->len = 1;
+		}
+		else{
+			/* Out of burst slots: extend the last burst (rewrites unchanged bytes) */
+			open = &plan->burst[plan->count - 1];
+			open->len = (uint8_t)(reg - open->reg + 1);
+		}
+		gap = 0;
+	}
+
+	/* Standby is only needed if measuring before and after */
+	if(!(from[ADXL_REG(POWER_CTL)] & MEASURE_ON)) plan->pause = 0;
+}
+
+/**
+ * @brief  Registers the profile table and precomputes every switch plan.
+ * @param  profiles: Profile table (must stay valid)
+ * @param  count: Number of profiles (<= ADXL_PROFILE_MAX)
+ * @return None
+ */
+void adxlProfileRegister(const ADXL_ProfileType *profiles, uint8_t count){
+	if(count > ADXL_PROFILE_MAX) count = ADXL_PROFILE_MAX;
+
+	profile_table = profiles;
+	profile_count = count;
+	profile_current = ADXL_PROFILE_NONE;
+
+	for(uint8_t from = 0; from < count; from++){
+		for(uint8_t to = 0; to < count; to++){
+			adxlProfilePlan(profiles[from].image, profiles[to].image, &profile_plan[from][to]);
+		}
+	}
+}
+
+/**
+ * @brief  Looks up a profile by name.
+ * @param  name: Profile name
+ * @return Profile index, or ADXL_PROFILE_NONE
+ */
+uint8_t adxlProfileFind(const char *name){
+	for(uint8_t i = 0; i < profile_count; i++){
+		if(strcmp(profile_table[i].name, name) == 0) return i;
+	}
+	return ADXL_PROFILE_NONE;
+}
+
+/**
+ * @brief  Returns the active profile.
+ * @return Profile index, or ADXL_PROFILE_NONE if registers were changed elsewhere
+ */
+uint8_t adxlProfileCurrent(void){
+	if(profile_current == ADXL_PROFILE_NONE) return ADXL_PROFILE_NONE;
+	if(memcmp(getShadow(), profile_table[profile_current].image, ADXL_SHADOW_SIZE) != 0) return ADXL_PROFILE_NONE;
+	return profile_current;
+}
+
+/**
+ * @brief  Marks a profile as active without writing it (e.g. after adxlStoreBoot()).
+ * @param  index: Profile index
+ * @return ADXL_OK, or ADXL_ERROR if the registers do not hold that profile
+ */
+uint8_t adxlProfileAssume(uint8_t index){
+	if(index >= profile_count) return ADXL_ERROR;
+	if(memcmp(getShadow(), profile_table[index].image, ADXL_SHADOW_SIZE) != 0) return ADXL_ERROR;
+
+	profile_current = index;
+	return ADXL_OK;
+}
+
+/* --------------------------------------------------
+ * Switching
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Switches to a profile with the minimum number of bus transactions.
+ * @param  index: Target profile
+ * @param  tail: Receives FIFO samples taken with the old settings when measurement
+ *               must pause (may be NULL to discard them)
+ * @return Number of bus transactions used, 0 if nothing changed / invalid index,
+ *         or ADXL_PROFILE_ERROR if a write failed
+ * @note   After a failed write the previous POWER_CTL is written back (so a paused
+ *         sensor measures again), no profile is current and the stream is marked
+ *         as reconfigured if anything was written.
+ */
+uint8_t adxlProfileSwitch(uint8_t index, ADXL_BlockType *tail){
+	static ADXL_BlockType scratch;
+	ADXL_BurstPlanType dynamic;
+	const ADXL_BurstPlanType *plan;
+	uint8_t from = adxlProfileCurrent();
+	uint8_t power_ctl = getShadow()[ADXL_REG(POWER_CTL)];
+	uint8_t transactions = 0;
+	uint8_t result = ADXL_OK;
+
+	if(index >= profile_count) return 0;
+
+	const uint8_t *to = profile_table[index].image;
+
+	if(from != ADXL_PROFILE_NONE){
+		plan = &profile_plan[from][index];
+	}
+	else{
+		adxlProfilePlan(getShadow(), to, &dynamic);
+		plan = &dynamic;
+	}
+
+	if(plan->count == 0 && !plan->power_ctl){
+		profile_current = index;
+		return 0;
+	}
+
+	if(plan->pause){
+		uint8_t standby = power_ctl & (uint8_t)~MEASURE_ON;
+
+		drainFifo((tail != NULL) ? tail : &scratch);
+		result = writeBurst(POWER_CTL, &standby, 1);
+		transactions++;
+	}
+
+	for(uint8_t b = 0; b < plan->count && result == ADXL_OK; b++){
+		result = writeBurst(plan->burst[b].reg, &to[ADXL_REG(plan->burst[b].reg)], plan->burst[b].len);
+		transactions++;
+	}
+
+	if(result == ADXL_OK && (plan->pause || plan->power_ctl)){
+		result = writeBurst(POWER_CTL, &to[ADXL_REG(POWER_CTL)], 1);
+		transactions++;
+	}
+
+	if(result != ADXL_OK){
+		profile_current = ADXL_PROFILE_NONE;
+		if(transactions > 1) markConfigChange();             //*Not only the failed write
+		if(plan->pause) writeBurst(POWER_CTL, &power_ctl, 1);   //*Resume measurement
+		return ADXL_PROFILE_ERROR;
+	}
+
+	markConfigChange();
+	profile_current = index;
+	return transactions;
+}
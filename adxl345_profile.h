@@ -0,0 +1,89 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_profile.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Named configuration profiles with burst switching (adxl345_profile.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - A profile is a complete image of registers 0x1D .. 0x38
+ *   - adxlProfileRegister() precomputes a burst plan for every
+ *     (from, to) pair: changed registers grouped into the fewest contiguous
+ *     multi-byte writes, skipping read-only registers
+ *   - adxlProfileSwitch() applies the plan; measurement is paused (standby)
+ *     only if BW_RATE, DATA_FORMAT or FIFO_CTL change, and only around the bursts
+ *   - If the registers were changed outside the profiles, a plan is built from
+ *     the shadow image on the fly
+ *
+ *  @usage
+ *   static const ADXL_ProfileType profiles[] = {
+ *       { "idle",      { ...28 register values... } },
+ *       { "vibration", { ... } },
+ *       { "transport", { ... } },
+ *   };
+ *   adxlProfileRegister(profiles, 3);
+ *   adxlProfileSwitch(adxlProfileFind("vibration"), &tail);
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_PROFILE_H_
+#define INC_ADXL345_PROFILE_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Profile setting value define
+ * --------------------------------------------------*/
+
+#ifndef ADXL_PROFILE_MAX
+#define ADXL_PROFILE_MAX 4
+#endif
+
+#define ADXL_PROFILE_MAX_BURSTS 8
+#define ADXL_PROFILE_BRIDGE 2        //*Unchanged registers worth rewriting to merge two bursts
+#define ADXL_PROFILE_NONE 0xFF
+#define ADXL_PROFILE_ERROR 0xFF      //*adxlProfileSwitch(): a register write failed
+
+/** Index of a register inside a profile image */
+#define ADXL_REG(reg) ((reg) - ADXL_SHADOW_FIRST)
+
+/* --------------------------------------------------
+ * 2. Profile Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	const char *name;
+	uint8_t image[ADXL_SHADOW_SIZE]; //*Register values, index ADXL_REG(reg)
+} ADXL_ProfileType;
+
+typedef struct{
+	uint8_t reg;
+	uint8_t len;
+} ADXL_BurstType;
+
+typedef struct{
+	uint8_t count;                   //*Number of bursts
+	uint8_t pause;                   //*1: enter standby around the bursts
+	uint8_t power_ctl;               //*1: POWER_CTL changes (written last)
+	ADXL_BurstType burst[ADXL_PROFILE_MAX_BURSTS];
+} ADXL_BurstPlanType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlProfileRegister(const ADXL_ProfileType *profiles, uint8_t count);
+uint8_t adxlProfileFind(const char *name);
+uint8_t adxlProfileCurrent(void);
+uint8_t adxlProfileAssume(uint8_t index);
+void adxlProfilePlan(const uint8_t *from, const uint8_t *to, ADXL_BurstPlanType *plan);
+uint8_t adxlProfileSwitch(uint8_t index, ADXL_BlockType *tail);
+
+#endif /* INC_ADXL345_PROFILE_H_ */
@@ -0,0 +1,204 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_rainflow.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Streaming rainflow cycle counting (adxl345_rainflow.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Four-point rule: for reversals A B C D, if |C-B| <= |B-A| and
+ *     |C-B| <= |D-C|, B-C is a closed cycle; B and C are removed.
+ *   - Work per sample is a compare in the common case; a reversal costs a
+ *     few stack operations.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_rainflow.h"
+#include <string.h>
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+ADXL_RainflowType adxlRainflow = {                 //*Defaults: 50 mg ranges, 1 g means from -4 g, 20 mg gate
+	.hist = { .range_step = 50, .mean_min = -4000, .mean_step = 1000 },
+	.gate = 20,
+};
+
+/**
+ * @brief  Adds half cycles of range |a-b| and mean (a+b)/2 to a histogram.
+ */
+static void rfCount(ADXL_RainflowHistType *hist, uint8_t axis, int32_t a, int32_t b, uint32_t halves){
+	int32_t range = (a > b) ? a - b : b - a;
+	int32_t mean = (a + b) / 2;
+	int32_t r = range / hist->range_step;
+	int32_t m = (mean - hist->mean_min) / hist->mean_step;
+
+	if(mean < hist->mean_min) m = 0;
+	if(r >= ADXL_RF_RANGE_BINS) r = ADXL_RF_RANGE_BINS - 1;
+	if(m >= ADXL_RF_MEAN_BINS) m = ADXL_RF_MEAN_BINS - 1;
+
+	hist->half_cycles[axis][r][m] += halves;
+}
+
+/**
+ * @brief  Pushes a reversal and extracts every cycle it closes.
+ */
+static void rfPush(ADXL_RainflowType *rf, uint8_t axis, int32_t point){
+	ADXL_RainflowAxisType *ax = &rf->axis[axis];
+	int32_t *s = ax->stack;
+
+	if(ax->depth == ADXL_RF_STACK){
+		/* Residue too deep: retire the oldest range as a half cycle */
+		rfCount(&rf->hist, axis, s[0], s[1], 1);
+		memmove(&s[0], &s[1], sizeof(s[0]) * (ADXL_RF_STACK - 1));
+		ax->depth--;
+		rf->overflows++;
+	}
+	s[ax->depth++] = point;
+
+	while(ax->depth >= 4){
+		int32_t a = s[ax->depth - 4], b = s[ax->depth - 3];
+		int32_t c = s[ax->depth - 2], d = s[ax->depth - 1];
+		int32_t inner = (c > b) ? c - b : b - c;
+
+		if(inner > ((b > a) ? b - a : a - b) || inner > ((d > c) ? d - c : c - d)) break;
+
+		rfCount(&rf->hist, axis, b, c, 2);
+		s[ax->depth - 3] = d;
+		ax->depth -= 2;
+	}
+}
+
+/**
+ * @brief  Initializes a rainflow counter.
+ * @param  rf: Pointer to ADXL_RainflowType structure
+ * @param  range_step: Range bin width (signal units, e.g. mg)
+ * @param  mean_min: Lower edge of the first mean bin
+ * @param  mean_step: Mean bin width
+ * @param  gate: Hysteresis: smaller reversals are treated as noise
+ * @return None
+ */
+void adxlRainflowInit(ADXL_RainflowType *rf, int32_t range_step, int32_t mean_min, int32_t mean_step, int32_t gate){
+	memset(rf, 0, sizeof(*rf));
+	rf->hist.range_step = (range_step > 0) ? range_step : 1;
+	rf->hist.mean_min = mean_min;
+	rf->hist.mean_step = (mean_step > 0) ? mean_step : 1;
+	rf->gate = gate;
+}
+
+/**
+ * @brief  Feeds one value of one axis.
+ * @param  rf: Pointer to ADXL_RainflowType structure
+ * @param  axis: 0 = X, 1 = Y, 2 = Z
+ * @param  value: Signal value (mg, or an integrated quantity)
+ * @return None
+ */
+void adxlRainflowAdd(ADXL_RainflowType *rf, uint8_t axis, int32_t value){
+	ADXL_RainflowAxisType *ax = &rf->axis[axis];
+
+	if(!ax->started){
+		ax->started = 1;
+		ax->extreme = value;
+		rfPush(rf, axis, value);                  //*The first value starts the history
+		return;
+	}
+
+	if(ax->dir == 0){
+		int32_t start = ax->stack[ax->depth - 1];
+		if(value - start > rf->gate) ax->dir = 1;
+		else if(start - value > rf->gate) ax->dir = -1;
+		else return;
+		ax->extreme = value;
+		return;
+	}
+
+	if(ax->dir > 0){
+		if(value > ax->extreme){
+			ax->extreme = value;
+		}
+		else if(ax->extreme - value > rf->gate){
+			rfPush(rf, axis, ax->extreme);         //*Peak confirmed
+			ax->dir = -1;
+			ax->extreme = value;
+		}
+	}
+	else{
+		if(value < ax->extreme){
+			ax->extreme = value;
+		}
+		else if(value - ax->extreme > rf->gate){
+			rfPush(rf, axis, ax->extreme);         //*Valley confirmed
+			ax->dir = 1;
+			ax->extreme = value;
+		}
+	}
+}
+
+/**
+ * @brief  Feeds every enabled axis of a block.
+ * @param  rf: Pointer to ADXL_RainflowType structure
+ * @param  block: Samples (mg after adxlStageConvert)
+ * @return None
+ */
+void adxlRainflowBlock(ADXL_RainflowType *rf, const ADXL_BlockType *block){
+	for(uint8_t a = 0; a < 3; a++){
+		if(block->axes_off & (ADXL_AXIS_X >> a)) continue;
+		const int16_t *v = &block->samples[0].x + a;
+		for(uint16_t i = 0; i < block->count; i++, v += 3) adxlRainflowAdd(rf, a, *v);
+	}
+}
+
+/**
+ * @brief  Copies the interval histogram and clears it; the residue is kept.
+ * @param  rf: Pointer to ADXL_RainflowType structure
+ * @param  out: Receives the histogram of the interval
+ * @return None
+ */
+void adxlRainflowTake(ADXL_RainflowType *rf, ADXL_RainflowHistType *out){
+	*out = rf->hist;
+	memset(rf->hist.half_cycles, 0, sizeof(rf->hist.half_cycles));
+}
+
+/**
+ * @brief  Adds the open residue (and the pending extreme) as half cycles.
+ * @param  rf: Pointer to ADXL_RainflowType structure (unchanged)
+ * @param  hist: Histogram to complete, with the same binning
+ * @return None
+ * @note   Use once, at the end of the analysed history.
+ */
+void adxlRainflowCloseResidue(const ADXL_RainflowType *rf, ADXL_RainflowHistType *hist){
+	for(uint8_t a = 0; a < 3; a++){
+		const ADXL_RainflowAxisType *ax = &rf->axis[a];
+
+		for(uint8_t i = 1; i < ax->depth; i++) rfCount(hist, a, ax->stack[i - 1], ax->stack[i], 1);
+		if(ax->dir != 0 && ax->depth > 0) rfCount(hist, a, ax->stack[ax->depth - 1], ax->extreme, 1);
+	}
+}
+
+/**
+ * @brief  Merges histograms (intervals or devices).
+ * @param  dst: Accumulating histogram
+ * @param  src: Histogram to add
+ * @return ADXL_OK, or ADXL_ERROR if the binning differs
+ */
+uint8_t adxlRainflowMerge(ADXL_RainflowHistType *dst, const ADXL_RainflowHistType *src){
+	if(dst->range_step != src->range_step || dst->mean_min != src->mean_min ||
+			dst->mean_step != src->mean_step) return ADXL_ERROR;
+
+	uint32_t *d = &dst->half_cycles[0][0][0];
+	const uint32_t *s = &src->half_cycles[0][0][0];
+	for(uint32_t i = 0; i < 3U * ADXL_RF_RANGE_BINS * ADXL_RF_MEAN_BINS; i++) d[i] += s[i];
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Pipeline stage: feeds the block into adxlRainflow.
+ * @param  block: Pipeline block (mg)
+ * @return None
+ */
+void adxlStageRainflow(ADXL_BlockType *block){
+	adxlRainflowBlock(&adxlRainflow, block);
+}
@@ -0,0 +1,97 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_rainflow.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Streaming rainflow cycle counting (adxl345_rainflow.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Per axis: a hysteresis gate turns the signal into reversals, and the
+ *     four-point method extracts closed cycles from a small reversal stack
+ *   - Cycles go into a range x mean histogram per axis, counted in half
+ *     cycles (a full cycle adds 2)
+ *   - The stack keeps the residue across blocks and intervals; at the end of
+ *     a campaign adxlRainflowCloseResidue() adds it as half cycles
+ *   - Histograms with the same binning are merged by adding counts
+ *     (intervals, devices)
+ *   - Input: mg from the pipeline (adxlStageRainflow, after Convert/Filter)
+ *     or any integrated signal through adxlRainflowAdd()
+ *
+ *  @usage
+ *   adxlRainflowInit(&adxlRainflow, 50, -4000, 1000, 20);   // 50 mg range bins, 1 g mean bins, 20 mg gate
+ *   #define STAGES(X, a) X(a, adxlStageAcquire, 1) X(a, adxlStageConvert, 1) \
+ *                        X(a, adxlStageFilter, 1) X(a, adxlStageRainflow, 1)
+ *   every hour: adxlRainflowTake(&adxlRainflow, &hist);  send(&hist);
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_RAINFLOW_H_
+#define INC_ADXL345_RAINFLOW_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Rainflow setting value define
+ * --------------------------------------------------*/
+
+#ifndef ADXL_RF_RANGE_BINS
+#define ADXL_RF_RANGE_BINS 16
+#endif
+
+#ifndef ADXL_RF_MEAN_BINS
+#define ADXL_RF_MEAN_BINS 8
+#endif
+
+#ifndef ADXL_RF_STACK
+#define ADXL_RF_STACK 32             //*Reversals kept per axis (residue)
+#endif
+
+/* --------------------------------------------------
+ * 2. Rainflow Typedef
+ * --------------------------------------------------*/
+
+/** Range x mean histogram, half cycles (1.5 KB with the defaults) */
+typedef struct{
+	int32_t range_step;              //*Range bin width (last bin is open-ended)
+	int32_t mean_min;                //*Lower edge of the first mean bin
+	int32_t mean_step;               //*Mean bin width (first/last bins are open-ended)
+	uint32_t half_cycles[3][ADXL_RF_RANGE_BINS][ADXL_RF_MEAN_BINS];
+} ADXL_RainflowHistType;
+
+typedef struct{
+	int32_t stack[ADXL_RF_STACK];    //*Reversals not yet closed into cycles
+	uint8_t depth;
+	int8_t dir;                      //*+1 rising, -1 falling, 0 before the first move
+	uint8_t started;
+	int32_t extreme;                 //*Running extreme since the last reversal
+} ADXL_RainflowAxisType;
+
+typedef struct{
+	ADXL_RainflowHistType hist;
+	ADXL_RainflowAxisType axis[3];
+	int32_t gate;                    //*Reversals smaller than this are ignored
+	uint32_t overflows;              //*Stack full: oldest reversal counted as a half cycle
+} ADXL_RainflowType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlRainflowInit(ADXL_RainflowType *rf, int32_t range_step, int32_t mean_min, int32_t mean_step, int32_t gate);
+void adxlRainflowAdd(ADXL_RainflowType *rf, uint8_t axis, int32_t value);
+void adxlRainflowBlock(ADXL_RainflowType *rf, const ADXL_BlockType *block);
+void adxlRainflowTake(ADXL_RainflowType *rf, ADXL_RainflowHistType *out);
+void adxlRainflowCloseResidue(const ADXL_RainflowType *rf, ADXL_RainflowHistType *hist);
+uint8_t adxlRainflowMerge(ADXL_RainflowHistType *dst, const ADXL_RainflowHistType *src);
+
+void adxlStageRainflow(ADXL_BlockType *block);
+extern ADXL_RainflowType adxlRainflow;
+
+#endif /* INC_ADXL345_RAINFLOW_H_ */
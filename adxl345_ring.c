@@ -0,0 +1,217 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_ring.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Single-producer multi-consumer block ring (adxl345_ring.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Sequence numbers are free-running uint32_t; slot = seq & (ADXL_RING_SLOTS - 1).
+ *   - The producer only looks at consumer cursors when the ring appears full,
+ *     and consumers only publish their cursor every ADXL_RING_BATCH blocks
+ *     (or when they run dry), so the shared cache lines are touched rarely.
+ *   - In ADXL_RING_OVERWRITE mode a slot can be rewritten while a consumer is
+ *     reading it. Check adxlRingValid() after processing a block.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_ring.h"
+#include <stddef.h>
+
+#define RING_MASK (ADXL_RING_SLOTS - 1U)
+
+_Static_assert((ADXL_RING_SLOTS & RING_MASK) == 0, "ADXL_RING_SLOTS must be a power of two");
+
+/* --------------------------------------------------
+ * Producer
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Initializes an empty ring without consumers.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @param  policy: ADXL_RING_BLOCK, ADXL_RING_DROP or ADXL_RING_OVERWRITE
+ * @param  wait: Called while the producer is blocked (may be NULL to spin)
+ * @return None
+ */
+void adxlRingInit(ADXL_RingType *ring, uint8_t policy, void (*wait)(void)){
+	atomic_init(&ring->head, 0);
+	ring->gate = 0;
+	ring->dropped = 0;
+	ring->policy = policy;
+	ring->wait = wait;
+
+	for(int i = 0; i < ADXL_RING_MAX_CONSUMERS; i++){
+		atomic_init(&ring->consumer[i].cursor, 0);
+		ring->consumer[i].next = 0;
+		ring->consumer[i].overruns = 0;
+		ring->consumer[i].active = 0;
+	}
+}
+
+/**
+ * @brief  Finds the cursor of the slowest active consumer.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @param  head: Current producer sequence
+ * @return Slowest cursor (head if there are no consumers)
+ */
+static uint32_t slowestCursor(ADXL_RingType *ring, uint32_t head){
+	uint32_t lag = 0;
+
+	for(int i = 0; i < ADXL_RING_MAX_CONSUMERS; i++){
+		if(!ring->consumer[i].active) continue;
+
+		uint32_t d = head - atomic_load_explicit(&ring->consumer[i].cursor, memory_order_acquire);
+		if(d > lag) lag = d;
+	}
+	return head - lag;
+}
+
+/**
+ * @brief  Claims the next slot for writing.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @return Pointer to the slot, or NULL if the block was dropped (ADXL_RING_DROP)
+ * @note   The slot becomes visible to consumers on adxlRingPublish().
+ */
+ADXL_BlockType *adxlRingClaim(ADXL_RingType *ring){
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+	if(ring->policy != ADXL_RING_OVERWRITE){
+		while(head - ring->gate >= ADXL_RING_SLOTS){
+			ring->gate = slowestCursor(ring, head);
+			if(head - ring->gate < ADXL_RING_SLOTS) break;
+
+			if(ring->policy == ADXL_RING_DROP){
+				ring->dropped++;
+				return NULL;
+			}
+			if(ring->wait != NULL) ring->wait();
+		}
+	}
+
+	/* Overwrite: the previous head store must be visible before any write to
+	 * the reused slot, or adxlRingValid() could accept a torn block (pairs with
+	 * the acquire fence there, as publishLatest()/readLatest() do) */
+	if(ring->policy == ADXL_RING_OVERWRITE) atomic_thread_fence(memory_order_release);
+
+	ADXL_BlockType *block = &ring->slot[head & RING_MASK];
+	block->seq = head;
+	return block;
+}
+
+/**
+ * @brief  Publishes the slot returned by the last adxlRingClaim().
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @return None
+ */
+void adxlRingPublish(ADXL_RingType *ring){
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	atomic_store_explicit(&ring->head, head + 1U, memory_order_release);
+}
+
+/* --------------------------------------------------
+ * Consumer
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Registers a consumer starting at the current head.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @return Consumer id, or -1 if all consumer slots are in use
+ */
+int adxlRingAddConsumer(ADXL_RingType *ring){
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	for(int i = 0; i < ADXL_RING_MAX_CONSUMERS; i++){
+		ADXL_RingConsumerType *c = &ring->consumer[i];
+		if(c->active) continue;
+
+		c->next = head;
+		c->overruns = 0;
+		atomic_store_explicit(&c->cursor, head, memory_order_release);
+		c->active = 1;
+		return i;
+	}
+	return -1;
+}
+
+/**
+ * @brief  Unregisters a consumer so it no longer holds back the producer.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @param  id: Consumer id
+ * @return None
+ */
+void adxlRingRemoveConsumer(ADXL_RingType *ring, int id){
+	ring->consumer[id].active = 0;
+}
+
+/**
+ * @brief  Returns the number of published blocks not yet released by this consumer.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @param  id: Consumer id
+ * @return Number of blocks readable with adxlRingGet()
+ */
+uint32_t adxlRingAvailable(ADXL_RingType *ring, int id){
+	ADXL_RingConsumerType *c = &ring->consumer[id];
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	/* Overwrite: the slot at 'head' may already be in use by the producer */
+	if(ring->policy == ADXL_RING_OVERWRITE && head - c->next > ADXL_RING_SLOTS - 1U){
+		uint32_t oldest = head - (ADXL_RING_SLOTS - 1U);
+		c->overruns += oldest - c->next;
+		c->next = oldest;
+	}
+
+	uint32_t avail = head - c->next;
+
+	/* Running dry: flush the batched cursor so a blocked producer can proceed */
+	if(avail == 0 && atomic_load_explicit(&c->cursor, memory_order_relaxed) != c->next){
+		atomic_store_explicit(&c->cursor, c->next, memory_order_release);
+	}
+	return avail;
+}
+
+/**
+ * @brief  Returns a published block without copying it.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @param  id: Consumer id
+ * @param  index: 0 .. adxlRingAvailable() - 1
+ * @return Pointer to the block
+ */
+const ADXL_BlockType *adxlRingGet(ADXL_RingType *ring, int id, uint32_t index){
+	return &ring->slot[(ring->consumer[id].next + index) & RING_MASK];
+}
+
+/**
+ * @brief  Checks that a block was not overwritten while it was being read.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @param  id: Consumer id
+ * @param  index: Same index as passed to adxlRingGet()
+ * @return 1 if the block is still intact, 0 if it was overwritten
+ * @note   Always 1 unless the policy is ADXL_RING_OVERWRITE.
+ */
+uint8_t adxlRingValid(ADXL_RingType *ring, int id, uint32_t index){
+	if(ring->policy != ADXL_RING_OVERWRITE) return 1;
+
+	atomic_thread_fence(memory_order_acquire);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+	return (head - (ring->consumer[id].next + index)) < ADXL_RING_SLOTS;
+}
+
+/**
+ * @brief  Releases blocks after processing.
+ * @param  ring: Pointer to ADXL_RingType structure
+ * @param  id: Consumer id
+ * @param  count: Number of blocks to release (normally the whole batch)
+ * @return None
+ */
+void adxlRingRelease(ADXL_RingType *ring, int id, uint32_t count){
+	ADXL_RingConsumerType *c = &ring->consumer[id];
+
+	c->next += count;
+	if(c->next - atomic_load_explicit(&c->cursor, memory_order_relaxed) >= ADXL_RING_BATCH){
+		atomic_store_explicit(&c->cursor, c->next, memory_order_release);
+	}
+}
@@ -0,0 +1,102 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_ring.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Single-producer multi-consumer block ring (adxl345_ring.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - One producer publishes ADXL_BlockType slots, every consumer sees every slot
+ *   - Each consumer owns a cursor over the shared slots: blocks are never copied
+ *   - Backpressure policy: block, drop newest, or overwrite oldest
+ *   - Consumer cursors are published in batches to limit cache-line traffic
+ *
+ *  @usage
+ *   Producer:
+ *     ADXL_BlockType *b = adxlRingClaim(&ring);
+ *     if(b != NULL){ ...fill b...; adxlRingPublish(&ring); }
+ *
+ *   Consumer:
+ *     uint32_t n = adxlRingAvailable(&ring, id);
+ *     for(i = 0; i < n; i++) process(adxlRingGet(&ring, id, i));
+ *     adxlRingRelease(&ring, id, n);
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_RING_H_
+#define INC_ADXL345_RING_H_
+
+#include <stdatomic.h>
+#include "adxl345_types.h"
+
+/* --------------------------------------------------
+ * 1. Ring setting value define
+ * --------------------------------------------------*/
+
+#ifndef ADXL_RING_SLOTS
+#define ADXL_RING_SLOTS 64           //*Must be a power of two
+#endif
+
+#ifndef ADXL_RING_MAX_CONSUMERS
+#define ADXL_RING_MAX_CONSUMERS 16
+#endif
+
+#ifndef ADXL_RING_BATCH
+#define ADXL_RING_BATCH 8            //*Consumer cursor is published every N blocks
+#endif
+
+#ifndef ADXL_CACHE_LINE
+#define ADXL_CACHE_LINE 64
+#endif
+
+#define ADXL_RING_BLOCK 0            //*Producer waits for the slowest consumer
+#define ADXL_RING_DROP 1             //*Newest block is dropped when full
+#define ADXL_RING_OVERWRITE 2        //*Oldest block is overwritten, consumers skip ahead
+
+/* --------------------------------------------------
+ * 2. Ring Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	_Alignas(ADXL_CACHE_LINE) _Atomic uint32_t cursor;  //*Published cursor (seen by producer)
+	uint32_t next;                                      //*Private cursor (next block to read)
+	uint32_t overruns;                                  //*Blocks lost to overwrite
+	uint8_t active;
+} ADXL_RingConsumerType;
+
+typedef struct{
+	ADXL_BlockType slot[ADXL_RING_SLOTS];
+
+	_Alignas(ADXL_CACHE_LINE) _Atomic uint32_t head;    //*Number of published blocks
+	uint32_t gate;                                      //*Cached slowest consumer cursor
+	uint32_t dropped;
+	uint8_t policy;
+	void (*wait)(void);                                 //*Called while blocked (e.g. sched_yield)
+
+	ADXL_RingConsumerType consumer[ADXL_RING_MAX_CONSUMERS];
+} ADXL_RingType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlRingInit(ADXL_RingType *ring, uint8_t policy, void (*wait)(void));
+int adxlRingAddConsumer(ADXL_RingType *ring);
+void adxlRingRemoveConsumer(ADXL_RingType *ring, int id);
+
+ADXL_BlockType *adxlRingClaim(ADXL_RingType *ring);
+void adxlRingPublish(ADXL_RingType *ring);
+
+uint32_t adxlRingAvailable(ADXL_RingType *ring, int id);
+const ADXL_BlockType *adxlRingGet(ADXL_RingType *ring, int id, uint32_t index);
+uint8_t adxlRingValid(ADXL_RingType *ring, int id, uint32_t index);
+void adxlRingRelease(ADXL_RingType *ring, int id, uint32_t count);
+
+#endif /* INC_ADXL345_RING_H_ */
@@ -0,0 +1,166 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_scrub.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Background configuration scrubbing against the shadow image (adxl345_scrub.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - 0x1D..0x38 cannot be read in one transaction without side effects:
+ *     INT_SOURCE (0x30) clears latched interrupts and DATAX0..DATAZ1 (0x32..0x37)
+ *     pop the FIFO. A pass is therefore three reads: 0x1D..0x2F, 0x31 and 0x38
+ *     (21 bytes).
+ *   - Restores use the profile burst planner, so a full reset is repaired with
+ *     a handful of writes, POWER_CTL last.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_scrub.h"
+#include "adxl345_profile.h"
+#include <string.h>
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+
+/* Configuration registers that can be read without side effects */
+static const ADXL_BurstType scrub_segment[] = {
+	{ THRESH_TAP, INT_MAP - THRESH_TAP + 1 },  //*0x1D..0x2F
+	{ DATA_FORMAT, 1 },
+	{ FIFO_CTL, 1 },
+};
+#define SCRUB_SEGMENTS (sizeof(scrub_segment) / sizeof(scrub_segment[0]))
+
+/**
+ * @brief  Initializes a scrubber.
+ * @param  scrub: Pointer to ADXL_ScrubType structure
+ * @param  interval_ms: Time between passes
+ * @param  budget: Max bytes read per call (ADXL_SCRUB_BUDGET_ALL for a whole pass)
+ * @return None
+ * @note   on_drift and devid_every may be changed after this call.
+ */
+void adxlScrubInit(ADXL_ScrubType *scrub, uint32_t interval_ms, uint8_t budget){
+	*scrub = (ADXL_ScrubType){0};
+	scrub->interval_ms = interval_ms;
+	scrub->budget = budget;
+	scrub->devid_every = ADXL_SCRUB_DEVID_EVERY;
+}
+
+/**
+ * @brief  Compares the image read in this pass with the shadow and restores
+ *         what drifted.
+ * @return Number of drifted registers
+ */
+static int scrubRestore(ADXL_ScrubType *scrub){
+	const uint8_t *shadow = getShadow();
+	ADXL_BurstPlanType plan;
+	int drifted = 0;
+
+	/* ACT_TAP_STATUS is status, not configuration */
+	scrub->image[ADXL_REG(ACT_TAP_STATUS)] = shadow[ADXL_REG(ACT_TAP_STATUS)];
+
+	for(uint8_t i = 0; i < ADXL_SHADOW_SIZE; i++){
+		if(scrub->image[i] == shadow[i]) continue;
+		drifted++;
+		if(scrub->on_drift != NULL) scrub->on_drift(ADXL_SHADOW_FIRST + i, shadow[i], scrub->image[i]);
+	}
+	if(drifted == 0) return 0;
+
+	/* Rewrite the shadow values: bursts first, POWER_CTL last */
+	adxlProfilePlan(scrub->image, shadow, &plan);
+	for(uint8_t b = 0; b < plan.count; b++){
+		if(writeBurst(plan.burst[b].reg, &shadow[ADXL_REG(plan.burst[b].reg)], plan.burst[b].len) != ADXL_OK){
+			scrub->bus_errors++;
+			return ADXL_SCRUB_BUS_ERROR;
+		}
+	}
+	if(plan.power_ctl && writeBurst(POWER_CTL, &shadow[ADXL_REG(POWER_CTL)], 1) != ADXL_OK){
+		scrub->bus_errors++;
+		return ADXL_SCRUB_BUS_ERROR;
+	}
+
+	/* Samples in the FIFO were taken with the drifted settings (or during the
+	 * writes): drop them, so only samples of the restored configuration get
+	 * the new config_seq */
+	discardFifo();
+	markConfigChange();
+	scrub->drifts++;
+	scrub->restored += (uint32_t)drifted;
+	return drifted;
+}
+
+/**
+ * @brief  Runs the scrubber if a pass is due, within the bus budget.
+ * @param  scrub: Pointer to ADXL_ScrubType structure
+ * @param  now_ms: Current time in milliseconds (e.g. HAL_GetTick())
+ * @return Registers restored in this call, 0 if none or not due,
+ *         ADXL_SCRUB_BUS_ERROR or ADXL_SCRUB_DEVID_ERROR
+ * @note   With a budget, a pass is spread over several calls (at least one
+ *         segment is read per call) and registers are restored by the last one.
+ */
+int adxlScrubPoll(ADXL_ScrubType *scrub, uint32_t now_ms){
+	uint16_t spent = 0;
+
+	if(!scrub->running){
+		if(!scrub->force && scrub->passes != 0 && (uint32_t)(now_ms - scrub->last_ms) < scrub->interval_ms) return 0;
+		scrub->last_ms = now_ms;
+		scrub->running = 1;
+		scrub->segment = 0;
+		memcpy(scrub->image, getShadow(), ADXL_SHADOW_SIZE);
+
+		if(scrub->force || (scrub->devid_every != 0 && (scrub->passes % scrub->devid_every) == 0)){
+			scrub->force = 0;
+			spent++;
+			scrub->bytes++;
+			if(checkDevId() != ADXL_OK){
+				scrub->devid_errors++;
+				scrub->running = 0;
+				scrub->passes++;
+				return ADXL_SCRUB_DEVID_ERROR;
+			}
+		}
+	}
+
+	while(scrub->segment < SCRUB_SEGMENTS){
+		const ADXL_BurstType *seg = &scrub_segment[scrub->segment];
+
+		if(scrub->budget != ADXL_SCRUB_BUDGET_ALL && spent != 0 && spent + seg->len > scrub->budget) return 0;
+
+		if(readBurst(seg->reg, &scrub->image[ADXL_REG(seg->reg)], seg->len) != ADXL_OK){
+			scrub->bus_errors++;
+			scrub->running = 0;
+			scrub->passes++;
+			return ADXL_SCRUB_BUS_ERROR;
+		}
+		scrub->bytes += seg->len;
+		spent += seg->len;
+		scrub->segment++;
+	}
+
+	scrub->running = 0;
+	scrub->passes++;
+	return scrubRestore(scrub);
+}
+
+/**
+ * @brief  Runs a complete pass now, DEVID included (ignores interval and budget).
+ * @param  scrub: Pointer to ADXL_ScrubType structure
+ * @param  now_ms: Current time in milliseconds
+ * @return Same as adxlScrubPoll()
+ * @note   Call after a suspected brown-out (e.g. supply-monitor interrupt).
+ *         A pass already in progress is restarted.
+ */
+int adxlScrubNow(ADXL_ScrubType *scrub, uint32_t now_ms){
+	uint8_t budget = scrub->budget;
+	int found;
+
+	scrub->budget = ADXL_SCRUB_BUDGET_ALL;
+	scrub->running = 0;
+	scrub->force = 1;
+	found = adxlScrubPoll(scrub, now_ms);
+	scrub->budget = budget;
+	return found;
+}
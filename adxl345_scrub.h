@@ -0,0 +1,82 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_scrub.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Background configuration scrubbing against the shadow image (adxl345_scrub.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - A brown-out or ESD event can reset the sensor silently: registers return
+ *     to defaults and sampling continues with the wrong configuration
+ *   - adxlScrubPoll() burst-reads the configuration registers, compares them
+ *     with the shadow image, restores the ones that drifted (fewest bursts,
+ *     POWER_CTL last) and reports the drift
+ *   - DEVID is checked every 'devid_every' passes; a wrong DEVID means the
+ *     device is absent or the bus is corrupt, and nothing is restored
+ *   - The check interval and the bytes read per call (bus budget) are configurable
+ *
+ *  @usage
+ *   ADXL_ScrubType scrub;
+ *   adxlScrubInit(&scrub, 1000, 0);            // full pass every second
+ *   main loop:  if(adxlScrubPoll(&scrub, HAL_GetTick()) > 0) log drift;
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_SCRUB_H_
+#define INC_ADXL345_SCRUB_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Scrub setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_SCRUB_BUDGET_ALL 0      //*Whole pass in one call
+#define ADXL_SCRUB_DEVID_EVERY 8     //*Default passes between DEVID checks
+
+/* Return values of adxlScrubPoll() besides the drift count */
+#define ADXL_SCRUB_BUS_ERROR  -1
+#define ADXL_SCRUB_DEVID_ERROR -2
+
+/* --------------------------------------------------
+ * 2. Scrub Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint32_t interval_ms;            //*Time between passes
+	uint8_t budget;                  //*Max bytes read per call (0: whole pass)
+	uint8_t devid_every;             //*Passes between DEVID checks (0: never)
+	void (*on_drift)(uint8_t reg, uint8_t expected, uint8_t actual);
+
+	/* State */
+	uint32_t last_ms;
+	uint8_t segment;                 //*Next segment to read (0: pass starts)
+	uint8_t running;                 //*A pass is in progress
+	uint8_t force;                   //*Next pass starts now and checks DEVID
+	uint8_t image[ADXL_SHADOW_SIZE]; //*Registers read in the current pass
+
+	/* Counters */
+	uint32_t passes;
+	uint32_t drifts;                 //*Passes that found at least one drifted register
+	uint32_t restored;               //*Registers rewritten
+	uint32_t devid_errors;
+	uint32_t bus_errors;
+	uint32_t bytes;                  //*Bus bytes read by the scrubber
+} ADXL_ScrubType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlScrubInit(ADXL_ScrubType *scrub, uint32_t interval_ms, uint8_t budget);
+int adxlScrubPoll(ADXL_ScrubType *scrub, uint32_t now_ms);
+int adxlScrubNow(ADXL_ScrubType *scrub, uint32_t now_ms);
+
+#endif /* INC_ADXL345_SCRUB_H_ */
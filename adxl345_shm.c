@@ -0,0 +1,140 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_shm.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Shared-memory block publisher (adxl345_shm.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Linux only (shm_open, mmap, futex).
+ *   - The object is created as /dev/shm/adxl345-<name>.
+ *
+ *******************************************************************************
+ */
+
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+#include "adxl345_shm.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/**
+ * @brief  Checks that a mapped region was created with this build's layout.
+ * @param  region: Mapped region
+ * @return 1 if compatible, 0 otherwise
+ */
+static uint8_t regionCompatible(const ADXL_ShmRegionType *region){
+	return region->magic == ADXL_SHM_MAGIC && region->version == ADXL_SHM_VERSION &&
+			region->slots == ADXL_RING_SLOTS && region->block_size == sizeof(ADXL_BlockType);
+}
+
+/**
+ * @brief  Creates the shared-memory object (or takes over a stale one) and maps it.
+ * @param  pub: Pointer to ADXL_ShmPubType structure
+ * @param  name: Stream name
+ * @return 0 on success, -1 on failure
+ * @note   An existing object with a compatible layout is reused in place and its
+ *         head keeps counting, so subscribers of a restarted publisher stay
+ *         attached. The publisher holds an flock() on the object: a second
+ *         publisher for the same name fails instead of replacing it.
+ */
+int adxlShmCreate(ADXL_ShmPubType *pub, const char *name){
+	struct stat st;
+
+	snprintf(pub->name, sizeof(pub->name), "/adxl345-%s", name);
+
+	pub->fd = shm_open(pub->name, O_CREAT | O_RDWR, 0644);
+	if(pub->fd < 0){
+		printf("Error: Failed to create %s\r\n", pub->name);
+		return -1;
+	}
+
+	if(flock(pub->fd, LOCK_EX | LOCK_NB) != 0){
+		printf("Error: %s already has a publisher\r\n", pub->name);
+		close(pub->fd);
+		return -1;
+	}
+
+	/* A stale object with another layout: subscribers of it cannot be kept */
+	if(fstat(pub->fd, &st) == 0 && st.st_size != 0 && st.st_size != (off_t)sizeof(ADXL_ShmRegionType)){
+		close(pub->fd);
+		shm_unlink(pub->name);
+		return adxlShmCreate(pub, name);
+	}
+
+	if(ftruncate(pub->fd, sizeof(ADXL_ShmRegionType)) != 0){
+		printf("Error: Failed to size %s\r\n", pub->name);
+		close(pub->fd);
+		return -1;
+	}
+
+	pub->region = mmap(NULL, sizeof(ADXL_ShmRegionType), PROT_READ | PROT_WRITE, MAP_SHARED, pub->fd, 0);
+	if(pub->region == MAP_FAILED){
+		printf("Error: Failed to map %s\r\n", pub->name);
+		close(pub->fd);
+		return -1;
+	}
+
+	/* Same layout: continue the existing stream */
+	if(regionCompatible(pub->region)) return 0;
+
+	adxlRingInit(&pub->region->ring, ADXL_RING_OVERWRITE, NULL);
+	atomic_init(&pub->region->waiters, 0);
+	pub->region->slots = ADXL_RING_SLOTS;
+	pub->region->block_size = sizeof(ADXL_BlockType);
+	pub->region->version = ADXL_SHM_VERSION;
+
+	/* Magic last: subscribers treat the region as ready once it is set */
+	atomic_thread_fence(memory_order_release);
+	pub->region->magic = ADXL_SHM_MAGIC;
+	return 0;
+}
+
+/**
+ * @brief  Unmaps and removes the shared-memory object.
+ * @param  pub: Pointer to ADXL_ShmPubType structure
+ * @return None
+ * @note   Subscribers that still have it mapped keep their pages until they unmap.
+ */
+void adxlShmDestroy(ADXL_ShmPubType *pub){
+	munmap(pub->region, sizeof(ADXL_ShmRegionType));
+	close(pub->fd);
+	shm_unlink(pub->name);
+}
+
+/**
+ * @brief  Claims the next slot for writing.
+ * @param  pub: Pointer to ADXL_ShmPubType structure
+ * @return Pointer to the slot in shared memory
+ */
+ADXL_BlockType *adxlShmClaim(ADXL_ShmPubType *pub){
+	return adxlRingClaim(&pub->region->ring);
+}
+
+/**
+ * @brief  Publishes the claimed slot and wakes sleeping subscribers.
+ * @param  pub: Pointer to ADXL_ShmPubType structure
+ * @return None
+ */
+void adxlShmPublish(ADXL_ShmPubType *pub){
+	adxlRingPublish(&pub->region->ring);
+
+	/* Order the head store before the waiters load (pairs with adxlShmWait) */
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load_explicit(&pub->region->waiters, memory_order_relaxed) != 0){
+		syscall(SYS_futex, &pub->region->ring.head, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+#endif /* __linux__ */
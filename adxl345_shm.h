@@ -0,0 +1,98 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_shm.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Shared-memory block publication for Linux gateways (adxl345_shm.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - The publisher places an ADXL_RingType (overwrite policy) in a POSIX
+ *     shared-memory object; subscribers map the same pages and read blocks
+ *     in place, without copying
+ *   - Subscribers sleep on the ring head with a futex; the publisher only
+ *     issues FUTEX_WAKE when somebody is waiting
+ *   - A slow subscriber never stalls the publisher: it skips ahead and the
+ *     lost blocks are counted in 'overruns'
+ *   - A restarted publisher reuses a compatible object, so subscribers stay attached;
+ *     only one publisher per name is allowed (flock on the object)
+ *   - adxl345_shm_sub.c is the stand-alone subscriber side and only needs this header
+ *
+ *  @usage
+ *   Publisher:
+ *     adxlShmCreate(&pub, "vib0");
+ *     ADXL_BlockType *b = adxlShmClaim(&pub); ...fill...; adxlShmPublish(&pub);
+ *
+ *   Subscriber (another process):
+ *     adxlShmSubscribe(&sub, "vib0");
+ *     uint32_t n = adxlShmWait(&sub, 100);
+ *     for(i = 0; i < n; i++){ b = adxlShmGet(&sub, i); ...; if(!adxlShmValid(&sub, i)) discard; }
+ *     adxlShmRelease(&sub, n);
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_SHM_H_
+#define INC_ADXL345_SHM_H_
+
+#include "adxl345_ring.h"
+
+/* --------------------------------------------------
+ * 1. Shared memory setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_SHM_MAGIC 0x41445831U   //*'ADX1'
+#define ADXL_SHM_VERSION 1U
+#define ADXL_SHM_NAME_MAX 64
+
+/* --------------------------------------------------
+ * 2. Shared memory Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slots;                  //*ADXL_RING_SLOTS of the publisher
+	uint32_t block_size;             //*sizeof(ADXL_BlockType) of the publisher
+	_Atomic uint32_t waiters;        //*Subscribers currently sleeping on ring.head
+	ADXL_RingType ring;              //*ring.head is the futex word
+} ADXL_ShmRegionType;
+
+typedef struct{
+	ADXL_ShmRegionType *region;
+	int fd;
+	char name[ADXL_SHM_NAME_MAX];
+} ADXL_ShmPubType;
+
+typedef struct{
+	ADXL_ShmRegionType *region;
+	int fd;
+	uint32_t next;                   //*Next block to read
+	uint32_t overruns;               //*Blocks overwritten before they were read
+} ADXL_ShmSubType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+/* Publisher (adxl345_shm.c) */
+int adxlShmCreate(ADXL_ShmPubType *pub, const char *name);
+void adxlShmDestroy(ADXL_ShmPubType *pub);
+ADXL_BlockType *adxlShmClaim(ADXL_ShmPubType *pub);
+void adxlShmPublish(ADXL_ShmPubType *pub);
+
+/* Subscriber (adxl345_shm_sub.c) */
+int adxlShmSubscribe(ADXL_ShmSubType *sub, const char *name);
+void adxlShmUnsubscribe(ADXL_ShmSubType *sub);
+uint32_t adxlShmPoll(ADXL_ShmSubType *sub);
+uint32_t adxlShmWait(ADXL_ShmSubType *sub, uint32_t timeout_ms);
+const ADXL_BlockType *adxlShmGet(ADXL_ShmSubType *sub, uint32_t index);
+uint8_t adxlShmValid(ADXL_ShmSubType *sub, uint32_t index);
+void adxlShmRelease(ADXL_ShmSubType *sub, uint32_t count);
+
+#endif /* INC_ADXL345_SHM_H_ */
@@ -0,0 +1,157 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_shm_sub.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Shared-memory block subscriber (adxl345_shm_sub.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Stand-alone: depends only on adxl345_shm.h, not on the rest of the library.
+ *   - Blocks are read in place. The publisher may overwrite a slot while it is
+ *     being read, so check adxlShmValid() after processing.
+ *
+ *******************************************************************************
+ */
+
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+#include "adxl345_shm.h"
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define SHM_MASK (ADXL_RING_SLOTS - 1U)
+
+/**
+ * @brief  Maps an existing stream and starts at its current head.
+ * @param  sub: Pointer to ADXL_ShmSubType structure
+ * @param  name: Stream name used by the publisher
+ * @return 0 on success, -1 if the stream is missing or incompatible
+ */
+int adxlShmSubscribe(ADXL_ShmSubType *sub, const char *name){
+	char path[ADXL_SHM_NAME_MAX];
+	struct stat st;
+
+	snprintf(path, sizeof(path), "/adxl345-%s", name);
+	sub->fd = shm_open(path, O_RDWR, 0);
+	if(sub->fd < 0){
+		printf("Error: Stream %s not found\r\n", path);
+		return -1;
+	}
+
+	/* A short object would SIGBUS on first access instead of failing here */
+	if(fstat(sub->fd, &st) != 0 || st.st_size < (off_t)sizeof(ADXL_ShmRegionType)){
+		printf("Error: Stream %s has an incompatible layout\r\n", path);
+		close(sub->fd);
+		return -1;
+	}
+
+	sub->region = mmap(NULL, sizeof(ADXL_ShmRegionType), PROT_READ | PROT_WRITE, MAP_SHARED, sub->fd, 0);
+	if(sub->region == MAP_FAILED){
+		printf("Error: Failed to map %s\r\n", path);
+		close(sub->fd);
+		return -1;
+	}
+
+	if(sub->region->magic != ADXL_SHM_MAGIC || sub->region->version != ADXL_SHM_VERSION ||
+			sub->region->slots != ADXL_RING_SLOTS || sub->region->block_size != sizeof(ADXL_BlockType)){
+		printf("Error: Stream %s has an incompatible layout\r\n", path);
+		adxlShmUnsubscribe(sub);
+		return -1;
+	}
+	atomic_thread_fence(memory_order_acquire);
+
+	sub->next = atomic_load_explicit(&sub->region->ring.head, memory_order_acquire);
+	sub->overruns = 0;
+	return 0;
+}
+
+/**
+ * @brief  Unmaps the stream.
+ * @param  sub: Pointer to ADXL_ShmSubType structure
+ * @return None
+ */
+void adxlShmUnsubscribe(ADXL_ShmSubType *sub){
+	munmap(sub->region, sizeof(ADXL_ShmRegionType));
+	close(sub->fd);
+}
+
+/**
+ * @brief  Returns the number of unread blocks without sleeping.
+ * @param  sub: Pointer to ADXL_ShmSubType structure
+ * @return Number of blocks readable with adxlShmGet()
+ */
+uint32_t adxlShmPoll(ADXL_ShmSubType *sub){
+	uint32_t head = atomic_load_explicit(&sub->region->ring.head, memory_order_acquire);
+
+	/* The slot at 'head' may already be in use by the publisher */
+	if(head - sub->next > ADXL_RING_SLOTS - 1U){
+		uint32_t oldest = head - (ADXL_RING_SLOTS - 1U);
+		sub->overruns += oldest - sub->next;
+		sub->next = oldest;
+	}
+	return head - sub->next;
+}
+
+/**
+ * @brief  Sleeps until at least one block is available or the timeout expires.
+ * @param  sub: Pointer to ADXL_ShmSubType structure
+ * @param  timeout_ms: Maximum time to sleep
+ * @return Number of blocks readable with adxlShmGet() (0 on timeout)
+ */
+uint32_t adxlShmWait(ADXL_ShmSubType *sub, uint32_t timeout_ms){
+	struct timespec ts = { timeout_ms / 1000U, (long)(timeout_ms % 1000U) * 1000000L };
+	uint32_t avail = adxlShmPoll(sub);
+
+	if(avail != 0) return avail;
+
+	atomic_fetch_add_explicit(&sub->region->waiters, 1, memory_order_seq_cst);
+	/* Sleeps only if head still equals the value we have consumed up to */
+	syscall(SYS_futex, &sub->region->ring.head, FUTEX_WAIT, sub->next, &ts, NULL, 0);
+	atomic_fetch_sub_explicit(&sub->region->waiters, 1, memory_order_seq_cst);
+
+	return adxlShmPoll(sub);
+}
+
+/**
+ * @brief  Returns an unread block in place.
+ * @param  sub: Pointer to ADXL_ShmSubType structure
+ * @param  index: 0 .. available - 1
+ * @return Pointer to the block in shared memory
+ */
+const ADXL_BlockType *adxlShmGet(ADXL_ShmSubType *sub, uint32_t index){
+	return &sub->region->ring.slot[(sub->next + index) & SHM_MASK];
+}
+
+/**
+ * @brief  Checks that a block was not overwritten while it was being read.
+ * @param  sub: Pointer to ADXL_ShmSubType structure
+ * @param  index: Same index as passed to adxlShmGet()
+ * @return 1 if the block is intact, 0 if it must be discarded
+ */
+uint8_t adxlShmValid(ADXL_ShmSubType *sub, uint32_t index){
+	atomic_thread_fence(memory_order_acquire);
+	uint32_t head = atomic_load_explicit(&sub->region->ring.head, memory_order_relaxed);
+
+	return (head - (sub->next + index)) < ADXL_RING_SLOTS;
+}
+
+/**
+ * @brief  Marks blocks as read.
+ * @param  sub: Pointer to ADXL_ShmSubType structure
+ * @param  count: Number of blocks
+ * @return None
+ */
+void adxlShmRelease(ADXL_ShmSubType *sub, uint32_t count){
+	sub->next += count;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,300 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_sim.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Register-level ADXL345 simulator for host builds (adxl345_sim.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Host only: build with -DADXL_USE_LINUX together with adxl345_linux.c.
+ *   - The sample source returns acceleration in mg; the simulator converts it
+ *     according to DATA_FORMAT (range, FULL_RES, JUSTIFY) like the device does.
+ *   - ODR follows the datasheet rate codes (0x0A = 100 Hz, 0x0F = 3200 Hz).
+ *
+ *******************************************************************************
+ */
+
+#if defined(ADXL_USE_LINUX)
+
+#include "adxl345.h"
+#include "adxl345_sim.h"
+#include <string.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
+
+ADXL_SimType adxlSim;
+
+/* --------------------------------------------------
+ * Sample Generation
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Default source: device lying flat (+1 g on Z).
+ */
+static ADXL_SampleType restingSource(uint64_t now_us){
+	(void)now_us;
+	ADXL_SampleType s = { 0, 0, 1000 };
+	return s;
+}
+
+/**
+ * @brief  Converts one axis from mg to register format according to DATA_FORMAT.
+ */
+static int16_t toRegister(int16_t mg){
+	uint8_t format = adxlSim.reg[DATA_FORMAT];
+	uint8_t range = format & 0x03;
+	int32_t lsb, limit;
+
+	if(format & FULL_RESOLUTION){
+		lsb = (int32_t)mg * 256 / 1000;              //*3.9 mg/LSB at every range
+		limit = 512 << range;
+	}
+	else{
+		lsb = (int32_t)mg * 256 / (1000 << range);   //*10-bit
+		limit = 512;
+	}
+
+	if(lsb > limit - 1) lsb = limit - 1;
+	if(lsb < -limit) lsb = -limit;
+
+	if(format & JUSTIFY_MSB){
+		lsb <<= (format & FULL_RESOLUTION) ? (3 - range) + 3 : 6;
+	}
+	return (int16_t)lsb;
+}
+
+/**
+ * @brief  Stores one conversion in the data registers and the FIFO.
+ */
+static void convert(void){
+	ADXL_SampleType mg = adxlSim.source(adxlSim.now_us);
+	ADXL_SampleType s = { toRegister(mg.x), toRegister(mg.y), toRegister(mg.z) };
+	uint8_t mode = adxlSim.reg[FIFO_CTL] & 0xC0;
+
+	adxlSim.reg[INT_SOURCE] |= DATA_READY_INT;
+
+	if(mode == FIFO_BYPASS){
+		adxlSim.fifo[0] = s;
+		adxlSim.fifo_count = 0;
+		memcpy(&adxlSim.reg[DATAX0], &s, 6);
+		return;
+	}
+
+	if(adxlSim.fifo_count == ADXL_SIM_FIFO_DEPTH){
+		adxlSim.reg[INT_SOURCE] |= OVERRUN_INT;
+		if(mode == FIFO_FIFO) return;                //*FIFO mode stops when full
+		memmove(&adxlSim.fifo[0], &adxlSim.fifo[1], sizeof(ADXL_SampleType) * (ADXL_SIM_FIFO_DEPTH - 1));
+		adxlSim.fifo_count--;
+	}
+	adxlSim.fifo[adxlSim.fifo_count++] = s;
+	memcpy(&adxlSim.reg[DATAX0], &adxlSim.fifo[0], 6);
+
+	if(adxlSim.fifo_count > (adxlSim.reg[FIFO_CTL] & 0x1F)){
+		adxlSim.reg[INT_SOURCE] |= WATERMARK_INT;
+	}
+}
+
+/**
+ * @brief  Returns the current output data rate in mHz (0 when not measuring).
+ */
+uint32_t adxlSimOdrMilliHz(void){
+	if(!(adxlSim.reg[POWER_CTL] & MEASURE_ON)) return 0;
+	return 3200000U >> (15 - (adxlSim.reg[BW_RATE] & 0x0F));
+}
+
+/**
+ * @brief  Advances simulated time and produces the conversions that fall in it.
+ * @param  us: Time step in microseconds
+ * @return None
+ */
+void adxlSimAdvance(uint64_t us){
+	uint64_t end = adxlSim.now_us + us;
+	uint32_t odr = adxlSimOdrMilliHz();
+
+	if(odr == 0){
+		adxlSim.now_us = end;
+		return;
+	}
+
+	uint64_t period = 1000000000ULL / odr;
+	while(adxlSim.next_sample_us <= end){
+		adxlSim.now_us = adxlSim.next_sample_us;
+		convert();
+		adxlSim.next_sample_us += period;
+	}
+	adxlSim.now_us = end;
+}
+
+/**
+ * @brief  Simulated time as a 32-bit nanosecond clock (for lowLatencySetClock()).
+ */
+uint32_t adxlSimClockNs(void){
+	return (uint32_t)(adxlSim.now_us * 1000U);
+}
+
+/**
+ * @brief  Restores the power-on register values and empties the FIFO.
+ * @param  source: Acceleration source in mg (NULL: resting on a table)
+ * @return None
+ */
+void adxlSimReset(ADXL_SimSourceType source){
+	memset(&adxlSim, 0, sizeof(adxlSim));
+	adxlSim.reg[DEVID] = 0xE5;
+	adxlSim.reg[BW_RATE] = 0x0A;
+	adxlSim.reg[INT_SOURCE] = WATERMARK_INT;
+	adxlSim.source = (source != NULL) ? source : restingSource;
+	adxlSim.bus_hz = ADXL_SIM_I2C_HZ;
+	adxlSim.address = 0x53;
+}
+
+/* --------------------------------------------------
+ * Bus Access
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Charges one transaction of 'len' payload bytes to the timing model.
+ */
+static void busTime(uint16_t len, uint8_t read){
+	uint32_t bits;
+
+	if(adxlSim.spi){
+		bits = 8U * (1U + len) + 2U;                 //*command byte + data + CS edges
+	}
+	else{
+		bits = 1U + 9U + 9U + 9U * len + 1U;         //*S, addr, reg, data, P
+		if(read) bits += 1U + 9U;                    //*Sr, addr
+	}
+
+	adxlSim.transactions++;
+	adxlSim.bytes += len + 1U;
+	uint64_t us = ((uint64_t)bits * 1000000U + adxlSim.bus_hz - 1U) / adxlSim.bus_hz;
+	adxlSim.bus_us += us;
+	adxlSimAdvance(us);
+}
+
+/**
+ * @brief  Multi-byte register write (auto-increment), one bus transaction.
+ */
+void adxlSimWrite(uint8_t reg, const uint8_t *data, uint16_t len){
+	busTime(len, 0);
+
+	for(uint16_t i = 0; i < len; i++, reg++){
+		if(reg >= ADXL_SIM_REGS) break;
+		if(reg == DEVID || reg == ACT_TAP_STATUS || reg == INT_SOURCE || reg == FIFO_STATUS) continue;
+		if(reg >= DATAX0 && reg <= DATAZ1) continue;
+
+		uint8_t old = adxlSim.reg[reg];
+		adxlSim.reg[reg] = data[i];
+
+		if(reg == POWER_CTL && !(old & MEASURE_ON) && (data[i] & MEASURE_ON)){
+			uint32_t odr = adxlSimOdrMilliHz();
+			adxlSim.next_sample_us = adxlSim.now_us + 1000000000ULL / odr;
+		}
+		if(reg == FIFO_CTL && (data[i] & 0xC0) == FIFO_BYPASS){
+			adxlSim.fifo_count = 0;
+		}
+	}
+}
+
+/**
+ * @brief  Multi-byte register read (auto-increment), one bus transaction.
+ * @note   Reading through DATAZ1 pops one FIFO entry, as on the device.
+ */
+void adxlSimRead(uint8_t reg, uint8_t *data, uint16_t len){
+	uint8_t start = reg;
+
+	busTime(len, 1);
+
+	adxlSim.reg[FIFO_STATUS] = adxlSim.fifo_count;
+	for(uint16_t i = 0; i < len; i++, reg++){
+		data[i] = (reg < ADXL_SIM_REGS) ? adxlSim.reg[reg] : 0;
+	}
+
+	if(start <= DATAZ1 && reg > DATAX0){
+		adxlSim.reg[INT_SOURCE] &= (uint8_t)~DATA_READY_INT;
+
+		if(start <= DATAZ1 && reg > DATAZ1 && adxlSim.fifo_count > 0){
+			memmove(&adxlSim.fifo[0], &adxlSim.fifo[1], sizeof(ADXL_SampleType) * (ADXL_SIM_FIFO_DEPTH - 1));
+			adxlSim.fifo_count--;
+			memcpy(&adxlSim.reg[DATAX0], &adxlSim.fifo[0], 6);
+
+			if(adxlSim.fifo_count > 0) adxlSim.reg[INT_SOURCE] |= DATA_READY_INT;
+			if(adxlSim.fifo_count <= (adxlSim.reg[FIFO_CTL] & 0x1F)) adxlSim.reg[INT_SOURCE] &= (uint8_t)~WATERMARK_INT;
+		}
+	}
+	if(start <= INT_SOURCE && reg > INT_SOURCE){
+		adxlSim.reg[INT_SOURCE] &= (uint8_t)~(OVERRUN_INT | SINGLE_TAP_INT | DOUBLE_TAP_INT |
+				ACTIVITY_INT | INACTIVITY_INT | FREE_FALL_INT);
+	}
+}
+
+/* --------------------------------------------------
+ * File Descriptor Stand-in
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Returns a descriptor that adxl345_linux.c can hold in place of a device node.
+ * @return File descriptor (backed by /dev/null), or -1 on failure
+ */
+int adxlSimOpen(void){
+	return open("/dev/null", O_RDWR);
+}
+
+/**
+ * @brief  Executes an i2c-dev or spidev request against the simulator.
+ * @param  fd: Descriptor from adxlSimOpen() (unused)
+ * @param  request: I2C_SLAVE, I2C_RDWR, SPI_IOC_MESSAGE(1) or SPI_IOC_WR_*
+ * @param  arg: Request argument, as for ioctl()
+ * @return 0 on success, -1 for unsupported requests
+ */
+int adxlSimIoctl(int fd, unsigned long request, void *arg){
+	(void)fd;
+
+	if(request == I2C_SLAVE) return 0;
+
+	if(request == I2C_RDWR){
+		struct i2c_rdwr_ioctl_data *rdwr = arg;
+		struct i2c_msg *msg = rdwr->msgs;
+
+		if(msg[0].addr != adxlSim.address) return -1;   //*NACK: nobody at that address
+		if(rdwr->nmsgs == 1 && !(msg[0].flags & I2C_M_RD) && msg[0].len >= 1){
+			adxlSimWrite(msg[0].buf[0], &msg[0].buf[1], msg[0].len - 1);
+			return 0;
+		}
+		if(rdwr->nmsgs == 2 && msg[0].len == 1 && (msg[1].flags & I2C_M_RD)){
+			adxlSimRead(msg[0].buf[0], msg[1].buf, msg[1].len);
+			return 0;
+		}
+		return -1;
+	}
+
+	if(request == SPI_IOC_WR_MAX_SPEED_HZ){
+		adxlSim.spi = 1;
+		adxlSim.bus_hz = *(uint32_t*)arg;
+		return 0;
+	}
+	if(request == SPI_IOC_WR_MODE || request == SPI_IOC_WR_BITS_PER_WORD) return 0;
+
+	if(request == SPI_IOC_MESSAGE(1)){
+		struct spi_ioc_transfer *xfer = arg;
+		const uint8_t *tx = (const uint8_t*)(uintptr_t)xfer->tx_buf;
+		uint8_t *rx = (uint8_t*)(uintptr_t)xfer->rx_buf;
+
+		if(xfer->len < 2) return -1;
+		if(tx[0] & 0x80){
+			adxlSimRead(tx[0] & 0x3F, &rx[1], xfer->len - 1);
+		}
+		else{
+			adxlSimWrite(tx[0] & 0x3F, &tx[1], xfer->len - 1);
+		}
+		return 0;
+	}
+	return -1;
+}
+
+#endif /* ADXL_USE_LINUX */
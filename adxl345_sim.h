@@ -0,0 +1,80 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_sim.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Register-level ADXL345 simulator for host builds (adxl345_sim.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Register file with reset values, 32-entry FIFO (bypass/FIFO/stream)
+ *   - Samples are produced at the BW_RATE output data rate while MEASURE is set
+ *   - Timing model: every bus transaction advances simulated time by its
+ *     wire time at 'bus_hz', so drivers can be timed without hardware
+ *   - adxlSimIoctl() accepts the i2c-dev (I2C_RDWR) and spidev (SPI_IOC_MESSAGE)
+ *     requests used by adxl345_linux.c, which makes the simulator a drop-in
+ *     stand-in for /dev/i2c-N and /dev/spidevX.Y
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_SIM_H_
+#define INC_ADXL345_SIM_H_
+
+#include "adxl345_types.h"
+
+/* --------------------------------------------------
+ * 1. Simulator setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_SIM_REGS 0x40
+#define ADXL_SIM_FIFO_DEPTH 32
+#define ADXL_SIM_I2C_HZ 400000U      //*Default bus clock (I2C fast mode)
+
+/* --------------------------------------------------
+ * 2. Simulator Typedef
+ * --------------------------------------------------*/
+
+/** Produces the acceleration (in LSB) at simulated time 'now_us' */
+typedef ADXL_SampleType (*ADXL_SimSourceType)(uint64_t now_us);
+
+typedef struct{
+	uint8_t reg[ADXL_SIM_REGS];
+	ADXL_SampleType fifo[ADXL_SIM_FIFO_DEPTH];
+	uint8_t fifo_count;
+
+	uint64_t now_us;                 //*Simulated time
+	uint64_t next_sample_us;         //*Time of the next conversion
+	ADXL_SimSourceType source;
+
+	uint8_t address;                 //*I2C address the device answers (0x53)
+	uint32_t bus_hz;
+	uint8_t spi;                     //*1: time transactions as SPI, 0: as I2C
+	uint32_t transactions;
+	uint32_t bytes;
+	uint64_t bus_us;                 //*Total simulated wire time
+} ADXL_SimType;
+
+extern ADXL_SimType adxlSim;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlSimReset(ADXL_SimSourceType source);
+void adxlSimAdvance(uint64_t us);
+uint32_t adxlSimOdrMilliHz(void);
+uint32_t adxlSimClockNs(void);
+
+void adxlSimWrite(uint8_t reg, const uint8_t *data, uint16_t len);
+void adxlSimRead(uint8_t reg, uint8_t *data, uint16_t len);
+
+int adxlSimOpen(void);
+int adxlSimIoctl(int fd, unsigned long request, void *arg);
+
+#endif /* INC_ADXL345_SIM_H_ */
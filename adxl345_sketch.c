@@ -0,0 +1,290 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_sketch.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Mergeable fixed-memory quantile sketches (adxl345_sketch.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Integer only: the bucket index is the position of the leading one bit
+ *     plus the next SUB_BITS bits, so no FPU or log() is needed on the MCU.
+ *   - Quantiles are reported at the bucket midpoint.
+ *   - Linux build: link with -lpthread for adxlSketchMergeParallel().
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_sketch.h"
+#include <string.h>
+
+#if defined(ADXL_USE_LINUX)
+#include <pthread.h>
+#include <stdlib.h>
+#endif
+
+/* --------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------*/
+ADXL_SketchSetType adxlSketch;
+
+/* --------------------------------------------------
+ * Buckets
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Bucket index of a non-negative value (clamped to ADXL_SKETCH_MAX).
+ */
+static uint32_t bucketOf(uint32_t v){
+	uint32_t e = 0;
+
+	if(v > ADXL_SKETCH_MAX) v = ADXL_SKETCH_MAX;
+	if(v < ADXL_SKETCH_SUB) return v;
+
+	for(uint32_t t = v; t > 1; t >>= 1) e++;      //*Leading one bit
+	return ADXL_SKETCH_SUB * (e - ADXL_SKETCH_SUB_BITS + 1) +
+			((v >> (e - ADXL_SKETCH_SUB_BITS)) & (ADXL_SKETCH_SUB - 1));
+}
+
+/**
+ * @brief  Midpoint of a bucket.
+ */
+static uint32_t bucketValue(uint32_t index){
+	uint32_t e, lo, width;
+
+	if(index < ADXL_SKETCH_SUB) return index;
+
+	e = index / ADXL_SKETCH_SUB + ADXL_SKETCH_SUB_BITS - 1;
+	width = 1U << (e - ADXL_SKETCH_SUB_BITS);
+	lo = (1U << e) + (index % ADXL_SKETCH_SUB) * width;
+	return lo + width / 2;
+}
+
+/**
+ * @brief  Integer square root (magnitude).
+ */
+static uint32_t isqrt32(uint32_t v){
+	uint32_t r = 0, bit = 1U << 30;
+
+	while(bit > v) bit >>= 2;
+	while(bit != 0){
+		if(v >= r + bit){
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else{
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return r;
+}
+
+/* --------------------------------------------------
+ * Sketch
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Empties a sketch.
+ * @param  sketch: Pointer to ADXL_SketchType structure
+ * @return None
+ */
+void adxlSketchReset(ADXL_SketchType *sketch){
+	memset(sketch, 0, sizeof(*sketch));
+}
+
+/**
+ * @brief  Adds one value.
+ * @param  sketch: Pointer to ADXL_SketchType structure
+ * @param  value: Value (mg)
+ * @return None
+ */
+void adxlSketchAdd(ADXL_SketchType *sketch, int32_t value){
+	if(value < 0) sketch->neg[bucketOf((uint32_t)-value)]++;
+	else sketch->pos[bucketOf((uint32_t)value)]++;
+
+	if(sketch->count == 0 || value < sketch->min) sketch->min = value;
+	if(sketch->count == 0 || value > sketch->max) sketch->max = value;
+	sketch->count++;
+}
+
+/**
+ * @brief  Estimates a quantile.
+ * @param  sketch: Pointer to ADXL_SketchType structure
+ * @param  q_ppm: Quantile in parts per million (500000 = P50, 999000 = P99.9)
+ * @return Value at the quantile (bucket midpoint, clamped to min/max), 0 if empty
+ */
+int32_t adxlSketchQuantile(const ADXL_SketchType *sketch, uint32_t q_ppm){
+	uint64_t rank, seen = 0;
+	int32_t value = 0;
+
+	if(sketch->count == 0) return 0;
+	if(q_ppm > 1000000U) q_ppm = 1000000U;
+	rank = ((uint64_t)(sketch->count - 1) * q_ppm + 500000U) / 1000000U;  //*0-based
+
+	/* Ascending order: most negative first */
+	for(uint32_t i = ADXL_SKETCH_BUCKETS; i-- > 0; ){
+		seen += sketch->neg[i];
+		if(seen > rank){
+			value = -(int32_t)bucketValue(i);
+			goto found;
+		}
+	}
+	for(uint32_t i = 0; i < ADXL_SKETCH_BUCKETS; i++){
+		seen += sketch->pos[i];
+		if(seen > rank){
+			value = (int32_t)bucketValue(i);
+			goto found;
+		}
+	}
+	value = sketch->max;
+
+found:
+	if(value < sketch->min) value = sketch->min;
+	if(value > sketch->max) value = sketch->max;
+	return value;
+}
+
+/**
+ * @brief  Merges src into dst (exact: bucket counts add).
+ * @param  dst: Accumulating sketch
+ * @param  src: Sketch to add
+ * @return None
+ */
+void adxlSketchMerge(ADXL_SketchType *dst, const ADXL_SketchType *src){
+	if(src->count == 0) return;
+	for(uint32_t i = 0; i < ADXL_SKETCH_BUCKETS; i++){
+		dst->neg[i] += src->neg[i];
+		dst->pos[i] += src->pos[i];
+	}
+	if(dst->count == 0 || src->min < dst->min) dst->min = src->min;
+	if(dst->count == 0 || src->max > dst->max) dst->max = src->max;
+	dst->count += src->count;
+}
+
+/* --------------------------------------------------
+ * Per-axis + magnitude set
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Empties every sketch of a set.
+ * @param  set: Pointer to ADXL_SketchSetType structure
+ * @return None
+ */
+void adxlSketchSetReset(ADXL_SketchSetType *set){
+	for(uint8_t a = 0; a < 3; a++) adxlSketchReset(&set->axis[a]);
+	adxlSketchReset(&set->mag);
+}
+
+/**
+ * @brief  Adds a block: every enabled axis and the magnitude.
+ * @param  set: Pointer to ADXL_SketchSetType structure
+ * @param  block: Samples in mg
+ * @return None
+ */
+void adxlSketchSetBlock(ADXL_SketchSetType *set, const ADXL_BlockType *block){
+	for(uint16_t i = 0; i < block->count; i++){
+		const int16_t *v = &block->samples[i].x;
+		uint32_t sq = 0;
+
+		for(uint8_t a = 0; a < 3; a++){
+			if(block->axes_off & (ADXL_AXIS_X >> a)) continue;
+			adxlSketchAdd(&set->axis[a], v[a]);
+			sq += (uint32_t)((int32_t)v[a] * v[a]);
+		}
+		adxlSketchAdd(&set->mag, (int32_t)isqrt32(sq));
+	}
+}
+
+/**
+ * @brief  Merges every sketch of src into dst.
+ * @param  dst: Accumulating set
+ * @param  src: Set to add
+ * @return None
+ */
+void adxlSketchSetMerge(ADXL_SketchSetType *dst, const ADXL_SketchSetType *src){
+	for(uint8_t a = 0; a < 3; a++) adxlSketchMerge(&dst->axis[a], &src->axis[a]);
+	adxlSketchMerge(&dst->mag, &src->mag);
+}
+
+/**
+ * @brief  Pipeline stage: feeds the block into adxlSketch.
+ * @param  block: Pipeline block (mg)
+ * @return None
+ */
+void adxlStageSketch(ADXL_BlockType *block){
+	adxlSketchSetBlock(&adxlSketch, block);
+}
+
+/* --------------------------------------------------
+ * Fleet merge (Linux)
+ * --------------------------------------------------*/
+
+#if defined(ADXL_USE_LINUX)
+
+typedef struct{
+	ADXL_SketchSetType partial;
+	const ADXL_SketchSetType *src;
+	uint32_t first;
+	uint32_t count;
+} SketchWorkType;
+
+static void *sketchWorker(void *arg){
+	SketchWorkType *work = arg;
+
+	adxlSketchSetReset(&work->partial);
+	for(uint32_t i = 0; i < work->count; i++) adxlSketchSetMerge(&work->partial, &work->src[work->first + i]);
+	return NULL;
+}
+
+/**
+ * @brief  Merges many sketch sets (e.g. one per device) into dst using threads.
+ * @param  dst: Accumulating set (its current content is kept)
+ * @param  src: Array of sets
+ * @param  count: Number of sets
+ * @param  threads: Worker threads (1 .. 64)
+ * @return 0 on success, -1 on failure
+ * @note   Each worker merges a contiguous slice into its own partial; the
+ *         partials are then added to dst. The result equals a serial merge.
+ */
+int adxlSketchMergeParallel(ADXL_SketchSetType *dst, const ADXL_SketchSetType *src, uint32_t count, uint8_t threads){
+	pthread_t tid[64];
+	SketchWorkType *work;
+	uint32_t first = 0;
+	uint8_t started = 0;
+	int status = 0;
+
+	if(threads < 1) threads = 1;
+	if(threads > 64) threads = 64;
+	if(threads > count) threads = (uint8_t)((count != 0) ? count : 1);
+
+	work = malloc(sizeof(SketchWorkType) * threads);
+	if(work == NULL) return -1;
+
+	for(uint8_t t = 0; t < threads; t++){
+		work[t].src = src;
+		work[t].first = first;
+		work[t].count = count / threads + ((t < count % threads) ? 1 : 0);
+		first += work[t].count;
+	}
+
+	for(uint8_t t = 1; t < threads; t++){
+		if(pthread_create(&tid[t], NULL, sketchWorker, &work[t]) != 0){
+			status = -1;
+			break;
+		}
+		started = t;
+	}
+	sketchWorker(&work[0]);                      //*The caller is worker 0
+
+	for(uint8_t t = 1; t <= started; t++) pthread_join(tid[t], NULL);
+
+	if(status == 0){
+		for(uint8_t t = 0; t < threads; t++) adxlSketchSetMerge(dst, &work[t].partial);
+	}
+	free(work);
+	return status;
+}
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_sketch.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Mergeable fixed-memory quantile sketches (adxl345_sketch.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Log-linear buckets (HDR-histogram layout): exact below 2^SUB_BITS, then
+ *     2^SUB_BITS buckets per power of two; every bucket is at most 1/16 wide
+ *     relative to its value (default), so any quantile is within ~3 %
+ *   - Fixed memory, no allocation: the whole int16 range and the magnitude
+ *     up to 65535 mg fit; nothing is ever collapsed or dropped
+ *   - Merging adds bucket counts: exact, associative and order-independent,
+ *     so windows and devices combine without loss of accuracy
+ *   - One sketch per axis (signed) and one for the magnitude
+ *   - Linux: adxlSketchMergeParallel() merges a fleet with worker threads
+ *
+ *  @usage
+ *   add adxlStageSketch after adxlStageConvert (samples in mg)
+ *   p99 = adxlSketchQuantile(&adxlSketch.mag, 990000);      // ppm
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_SKETCH_H_
+#define INC_ADXL345_SKETCH_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Sketch setting value define
+ * --------------------------------------------------*/
+
+#ifndef ADXL_SKETCH_SUB_BITS
+#define ADXL_SKETCH_SUB_BITS 4       //*Relative bucket width 2^-SUB_BITS
+#endif
+
+#define ADXL_SKETCH_SUB (1U << ADXL_SKETCH_SUB_BITS)
+#define ADXL_SKETCH_MAX 65535U       //*Largest magnitude kept exactly in range
+#define ADXL_SKETCH_BUCKETS (ADXL_SKETCH_SUB * (17U - ADXL_SKETCH_SUB_BITS))
+
+/* --------------------------------------------------
+ * 2. Sketch Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint32_t count;
+	int32_t min;
+	int32_t max;
+	uint32_t neg[ADXL_SKETCH_BUCKETS];   //*Negative values by magnitude
+	uint32_t pos[ADXL_SKETCH_BUCKETS];   //*Zero and positive values
+} ADXL_SketchType;
+
+typedef struct{
+	ADXL_SketchType axis[3];
+	ADXL_SketchType mag;                 //*|a| of the enabled axes
+} ADXL_SketchSetType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void adxlSketchReset(ADXL_SketchType *sketch);
+void adxlSketchAdd(ADXL_SketchType *sketch, int32_t value);
+int32_t adxlSketchQuantile(const ADXL_SketchType *sketch, uint32_t q_ppm);
+void adxlSketchMerge(ADXL_SketchType *dst, const ADXL_SketchType *src);
+
+void adxlSketchSetReset(ADXL_SketchSetType *set);
+void adxlSketchSetBlock(ADXL_SketchSetType *set, const ADXL_BlockType *block);
+void adxlSketchSetMerge(ADXL_SketchSetType *dst, const ADXL_SketchSetType *src);
+
+void adxlStageSketch(ADXL_BlockType *block);
+extern ADXL_SketchSetType adxlSketch;
+
+#if defined(ADXL_USE_LINUX)
+int adxlSketchMergeParallel(ADXL_SketchSetType *dst, const ADXL_SketchSetType *src, uint32_t count, uint8_t threads);
+#endif
+
+#endif /* INC_ADXL345_SKETCH_H_ */
@@ -0,0 +1,326 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_store.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Persistent calibration and configuration store (adxl345_store.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Erased flash reads 0xFF: a slot whose magic is 0xFFFFFFFF is free.
+ *   - Records are written in MCU byte order; the host file is only meant to be
+ *     read back by the host that wrote it.
+ *   - Only the page without the newest record is ever erased, so a power loss
+ *     at any point leaves at least the previous record readable.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_store.h"
+#include "adxl345_profile.h"
+#include "adxl345_frame.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(ADXL_USE_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+_Static_assert(sizeof(ADXL_StoreRecordType) == 80, "ADXL_StoreRecordType layout changed: bump ADXL_STORE_VERSION");
+_Static_assert(ADXL_STORE_SLOTS >= 2, "ADXL_STORE_PAGE_SIZE too small");
+
+#define STORE_CRC_LEN (offsetof(ADXL_StoreRecordType, crc))
+
+/* --------------------------------------------------
+ * Record Handling
+ * --------------------------------------------------*/
+
+/**
+ * @brief  Checks magic, version, length and CRC of a record.
+ * @return 1 if valid, 0 otherwise
+ */
+static uint8_t recordValid(const ADXL_StoreRecordType *record){
+	if(record->magic != ADXL_STORE_MAGIC) return 0;
+	if(record->version != ADXL_STORE_VERSION || record->length != sizeof(ADXL_StoreRecordType)) return 0;
+	return adxlFrameCrc((const uint8_t*)record, STORE_CRC_LEN) == record->crc;
+}
+
+/**
+ * @brief  Scans both pages for the newest valid record.
+ * @param  newest: Receives the newest valid record (may be NULL)
+ * @param  page: Receives the page holding it (0 if none)
+ * @param  free_slot: Receives the first free slot of that page, ADXL_STORE_SLOTS if full
+ * @return ADXL_OK if a valid record was found, ADXL_ERROR otherwise
+ */
+static uint8_t storeScan(ADXL_StoreRecordType *newest, uint8_t *page, uint32_t *free_slot){
+	ADXL_StoreRecordType record;
+	uint32_t page_free[ADXL_STORE_PAGES];
+	uint8_t found = 0;
+	uint32_t seq = 0;
+
+	*page = 0;
+	for(uint8_t p = 0; p < ADXL_STORE_PAGES; p++){
+		page_free[p] = ADXL_STORE_SLOTS;
+
+		for(uint32_t slot = 0; slot < ADXL_STORE_SLOTS; slot++){
+			if(adxlStoreRead(p, slot * sizeof(record), &record, sizeof(record)) != ADXL_OK) return ADXL_ERROR;
+
+			if(record.magic == 0xFFFFFFFFU){
+				/* Records are appended: everything after the first free slot is free */
+				page_free[p] = slot;
+				break;
+			}
+			if(!recordValid(&record)) continue;   //*Torn write or erase: skip, keep scanning
+
+			if(!found || (int32_t)(record.seq - seq) > 0){
+				found = 1;
+				seq = record.seq;
+				*page = p;
+				if(newest != NULL) *newest = record;
+			}
+		}
+	}
+	*free_slot = page_free[*page];
+	return found ? ADXL_OK : ADXL_ERROR;
+}
+
+/**
+ * @brief  Loads the newest valid record.
+ * @param  record: Destination
+ * @return ADXL_OK, or ADXL_ERROR if nothing valid is stored
+ */
+uint8_t adxlStoreLoad(ADXL_StoreRecordType *record){
+	uint8_t page;
+	uint32_t slot;
+
+	return storeScan(record, &page, &slot);
+}
+
+/**
+ * @brief  Saves the calibration and the current register image (shadow).
+ * @param  calib: Calibration to store (NULL: register image only)
+ * @param  profile: Active profile name (NULL or "" if none)
+ * @return ADXL_OK on success, ADXL_ERROR on backend failure
+ */
+uint8_t adxlStoreSave(const ADXL_CalibType *calib, const char *profile){
+	ADXL_StoreRecordType record;
+	ADXL_StoreRecordType newest;
+	uint8_t page;
+	uint32_t slot;
+
+	if(storeScan(&newest, &page, &slot) != ADXL_OK) newest.seq = 0;
+
+	memset(&record, 0, sizeof(record));
+	record.magic = ADXL_STORE_MAGIC;
+	record.version = ADXL_STORE_VERSION;
+	record.length = sizeof(record);
+	record.seq = newest.seq + 1;
+	record.flags = ADXL_STORE_IMAGE;
+	if(calib != NULL){
+		record.calib = *calib;
+		record.flags |= ADXL_STORE_CALIB;
+	}
+	memcpy(record.image, getShadow(), ADXL_SHADOW_SIZE);
+	if(profile != NULL) strncpy(record.profile, profile, ADXL_STORE_NAME_LEN - 1);
+	record.crc = adxlFrameCrc((const uint8_t*)&record, STORE_CRC_LEN);
+
+	if(slot >= ADXL_STORE_SLOTS){
+		/* Page full: continue on the other one, the newest record stays put */
+		page ^= 1U;
+		if(adxlStoreErase(page) != ADXL_OK) return ADXL_ERROR;
+		slot = 0;
+	}
+
+	if(adxlStoreWrite(page, slot * sizeof(record), &record, sizeof(record)) != ADXL_OK){
+		printf("Error: Failed to write store page %u slot %lu\r\n", page, (unsigned long)slot);
+		return ADXL_ERROR;
+	}
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Restores the stored configuration and calibration at boot.
+ * @param  calib: Receives the stored calibration (may be NULL)
+ * @return ADXL_OK if a record was applied, ADXL_ERROR if nothing valid is stored,
+ *         DEVID is wrong or a register write failed
+ * @note   Replaces adxlInit(): the sensor is put in standby, the whole image is
+ *         written in bursts (read-only registers skipped) and POWER_CTL last.
+ *         The sensor state before the MCU reset is not trusted.
+ *         Register the profiles first: the stored profile becomes the active
+ *         one again (adxlProfileCurrent()).
+ */
+uint8_t adxlStoreBoot(ADXL_CalibType *calib){
+	ADXL_StoreRecordType record;
+	ADXL_BurstPlanType plan;
+	uint8_t unknown[ADXL_SHADOW_SIZE];
+	uint8_t standby = 0;
+
+	if(adxlStoreLoad(&record) != ADXL_OK) return ADXL_ERROR;
+
+	if(checkDevId() != ADXL_OK){
+		printf("Error: DEVID mismatch, stored configuration not applied\r\n");
+		return ADXL_ERROR;
+	}
+
+	if(record.flags & ADXL_STORE_IMAGE){
+		/* Plan from the complement of the image: every register is written */
+		for(uint8_t i = 0; i < ADXL_SHADOW_SIZE; i++) unknown[i] = (uint8_t)~record.image[i];
+		unknown[ADXL_REG(POWER_CTL)] = standby;
+		adxlProfilePlan(unknown, record.image, &plan);
+
+		if(writeBurst(POWER_CTL, &standby, 1) != ADXL_OK) return ADXL_ERROR;
+		for(uint8_t b = 0; b < plan.count; b++){
+			if(writeBurst(plan.burst[b].reg, &record.image[ADXL_REG(plan.burst[b].reg)], plan.burst[b].len) != ADXL_OK){
+				return ADXL_ERROR;
+			}
+		}
+		if(writeBurst(POWER_CTL, &record.image[ADXL_REG(POWER_CTL)], 1) != ADXL_OK) return ADXL_ERROR;
+		markConfigChange();
+
+		record.profile[ADXL_STORE_NAME_LEN - 1] = '\0';
+		if(record.profile[0] != '\0') adxlProfileAssume(adxlProfileFind(record.profile));
+	}
+
+	if(calib != NULL && (record.flags & ADXL_STORE_CALIB)) *calib = record.calib;
+	return ADXL_OK;
+}
+
+/* --------------------------------------------------
+ * Backend
+ * --------------------------------------------------*/
+
+#if defined(ADXL_USE_LINUX)
+
+static const char *store_file = ADXL_STORE_FILE;
+
+/**
+ * @brief  Selects the file that stands in for the two flash pages.
+ * @param  path: File path (created on first write)
+ * @return None
+ */
+void adxlStoreSetFile(const char *path){
+	store_file = path;
+}
+
+/**
+ * @brief  Reads from the store file; a missing or short file reads as erased.
+ */
+uint8_t adxlStoreRead(uint8_t page, uint32_t offset, void *data, uint32_t len){
+	int fd = open(store_file, O_RDONLY);
+	ssize_t n = 0;
+
+	if(fd >= 0){
+		n = pread(fd, data, len, (off_t)page * ADXL_STORE_PAGE_SIZE + offset);
+		close(fd);
+		if(n < 0) n = 0;
+	}
+	memset((uint8_t*)data + n, 0xFF, len - (uint32_t)n);
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Writes to the store file.
+ */
+uint8_t adxlStoreWrite(uint8_t page, uint32_t offset, const void *data, uint32_t len){
+	int fd = open(store_file, O_WRONLY | O_CREAT, 0644);
+	ssize_t n;
+
+	if(fd < 0) return ADXL_ERROR;
+	n = pwrite(fd, data, len, (off_t)page * ADXL_STORE_PAGE_SIZE + offset);
+	if(fsync(fd) != 0) n = -1;
+	close(fd);
+	return (n == (ssize_t)len) ? ADXL_OK : ADXL_ERROR;
+}
+
+/**
+ * @brief  Erases one page of the store file (fills it with 0xFF).
+ */
+uint8_t adxlStoreErase(uint8_t page){
+	uint8_t erased[ADXL_STORE_PAGE_SIZE];
+
+	memset(erased, 0xFF, sizeof(erased));
+	return adxlStoreWrite(page, 0, erased, sizeof(erased));
+}
+
+#elif defined(ADXL_STORE_ADDRESS) && defined(ADXL_STORE_SECTOR) && \
+		defined(ADXL_STORE_ADDRESS_B) && defined(ADXL_STORE_SECTOR_B)
+
+static const uint32_t store_address[ADXL_STORE_PAGES] = { ADXL_STORE_ADDRESS, ADXL_STORE_ADDRESS_B };
+static const uint32_t store_sector[ADXL_STORE_PAGES] = { ADXL_STORE_SECTOR, ADXL_STORE_SECTOR_B };
+
+/**
+ * @brief  Reads from a memory-mapped flash page.
+ */
+__weak uint8_t adxlStoreRead(uint8_t page, uint32_t offset, void *data, uint32_t len){
+	memcpy(data, (const void*)(uintptr_t)(store_address[page] + offset), len);
+	return ADXL_OK;
+}
+
+/**
+ * @brief  Programs a flash page word by word (STM32F4; offset and len are
+ *         multiples of 4).
+ */
+__weak uint8_t adxlStoreWrite(uint8_t page, uint32_t offset, const void *data, uint32_t len){
+	const uint8_t *src = data;
+	uint8_t status = ADXL_OK;
+
+	HAL_FLASH_Unlock();
+	for(uint32_t i = 0; i < len; i += 4){
+		uint32_t word;
+		memcpy(&word, &src[i], 4);
+		if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, store_address[page] + offset + i, word) != HAL_OK){
+			status = ADXL_ERROR;
+			break;
+		}
+	}
+	HAL_FLASH_Lock();
+	return status;
+}
+
+/**
+ * @brief  Erases the flash sector holding one store page (STM32F4).
+ */
+__weak uint8_t adxlStoreErase(uint8_t page){
+	FLASH_EraseInitTypeDef erase = {0};
+	uint32_t error;
+	HAL_StatusTypeDef status;
+
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = store_sector[page];
+	erase.NbSectors = 1;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+	HAL_FLASH_Unlock();
+	status = HAL_FLASHEx_Erase(&erase, &error);
+	HAL_FLASH_Lock();
+	return (status == HAL_OK) ? ADXL_OK : ADXL_ERROR;
+}
+
+#else
+
+/**
+ * @brief  Flash backend hooks: override for the target's flash pages, or define
+ *         ADXL_STORE_ADDRESS/ADXL_STORE_SECTOR and ADXL_STORE_ADDRESS_B/
+ *         ADXL_STORE_SECTOR_B (STM32F4).
+ */
+__weak uint8_t adxlStoreRead(uint8_t page, uint32_t offset, void *data, uint32_t len){
+	(void)page; (void)offset;
+	memset(data, 0xFF, len);
+	return ADXL_OK;
+}
+
+__weak uint8_t adxlStoreWrite(uint8_t page, uint32_t offset, const void *data, uint32_t len){
+	(void)page; (void)offset; (void)data; (void)len;
+	printf("Error: No flash backend for the store\r\n");
+	return ADXL_ERROR;
+}
+
+__weak uint8_t adxlStoreErase(uint8_t page){
+	(void)page;
+	return ADXL_ERROR;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_store.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Persistent calibration and configuration store (adxl345_store.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - One record holds the calibration (offsets, correction matrix), the
+ *     register image 0x1D..0x38 and the active profile name
+ *   - Records are versioned and CRC-16 protected, and appended to one of two
+ *     flash pages. When it is full the other page is erased and the record
+ *     goes to its first slot, so the previous record survives a power loss
+ *     during the erase or the write. The newest valid record wins
+ *   - adxlStoreBoot() writes the stored image to the sensor and the shadow
+ *     in a few bursts: the first sample is correct without recalibration
+ *   - Backend: adxlStoreRead/Write/Erase(). On the MCU they are __weak
+ *     (STM32F4 sector implementation when ADXL_STORE_ADDRESS/ADXL_STORE_SECTOR
+ *     and ADXL_STORE_ADDRESS_B/ADXL_STORE_SECTOR_B are defined); on Linux they
+ *     use a file holding both pages (adxlStoreSetFile())
+ *
+ *  @usage
+ *   if(adxlStoreBoot(&adxlCalib) != ADXL_OK){
+ *       adxlInit(&Config);  calibrate();
+ *       adxlStoreSave(&adxlCalib, "default");
+ *   }
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_STORE_H_
+#define INC_ADXL345_STORE_H_
+
+#include "adxl345.h"
+#include "adxl345_pipeline.h"
+
+/* --------------------------------------------------
+ * 1. Store setting value define
+ * --------------------------------------------------*/
+
+#ifndef ADXL_STORE_PAGE_SIZE
+#define ADXL_STORE_PAGE_SIZE 2048
+#endif
+
+#ifndef ADXL_STORE_FILE
+#define ADXL_STORE_FILE "adxl345.store"
+#endif
+
+#define ADXL_STORE_MAGIC 0x31535841U     //*"AXS1"
+#define ADXL_STORE_VERSION 1
+#define ADXL_STORE_NAME_LEN 12
+
+/* Record flags */
+#define ADXL_STORE_CALIB 0x01            //*calib is valid
+#define ADXL_STORE_IMAGE 0x02            //*image is valid
+
+/* --------------------------------------------------
+ * 2. Store Typedef
+ * --------------------------------------------------*/
+
+/** On-flash record (80 bytes, MCU byte order, no padding) */
+typedef struct{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t length;                     //*sizeof(ADXL_StoreRecordType)
+	uint32_t seq;                        //*Generation, newest wins
+	ADXL_CalibType calib;
+	uint8_t image[ADXL_SHADOW_SIZE];     //*Registers 0x1D..0x38
+	char profile[ADXL_STORE_NAME_LEN];   //*Active profile name ("" if none)
+	uint16_t flags;
+	uint16_t crc;                        //*CRC-16/CCITT-FALSE of all bytes before it
+} ADXL_StoreRecordType;
+
+#define ADXL_STORE_SLOTS (ADXL_STORE_PAGE_SIZE / sizeof(ADXL_StoreRecordType))
+#define ADXL_STORE_PAGES 2                   //*Ping-pong: one page is erased while the other holds the newest record
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+uint8_t adxlStoreLoad(ADXL_StoreRecordType *record);
+uint8_t adxlStoreSave(const ADXL_CalibType *calib, const char *profile);
+uint8_t adxlStoreBoot(ADXL_CalibType *calib);
+
+/* Backend (page 0 or 1; offsets are relative to the start of the page) */
+uint8_t adxlStoreRead(uint8_t page, uint32_t offset, void *data, uint32_t len);
+uint8_t adxlStoreWrite(uint8_t page, uint32_t offset, const void *data, uint32_t len);
+uint8_t adxlStoreErase(uint8_t page);
+
+#if defined(ADXL_USE_LINUX)
+void adxlStoreSetFile(const char *path);
+#endif
+
+#endif /* INC_ADXL345_STORE_H_ */
@@ -0,0 +1,153 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_sync.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Sampling aligned to a control-loop timer tick (adxl345_sync.c)
+ *
+ *******************************************************************************
+ *
+ *  @note
+ *   - Timestamps are free-running uint32_t microseconds; differences wrap correctly.
+ *   - The ODR period is measured (EWMA 1/8), so the sensor's oscillator error
+ *     is tracked rather than assumed from BW_RATE.
+ *
+ *******************************************************************************
+ */
+
+#include "adxl345_sync.h"
+
+/**
+ * @brief  Initializes a sync context.
+ * @param  sync: Pointer to ADXL_SyncType structure
+ * @param  mode: ADXL_SYNC_FRESHEST or ADXL_SYNC_INTERPOLATE
+ * @param  tick_period_us: Control-loop period
+ * @return None
+ */
+void syncInit(ADXL_SyncType *sync, uint8_t mode, uint32_t tick_period_us){
+	*sync = (ADXL_SyncType){0};
+	sync->mode = mode;
+	sync->tick_period_us = tick_period_us;
+	sync->phase_min_us = INT32_MAX;
+	sync->phase_max_us = INT32_MIN;
+}
+
+/**
+ * @brief  Records a data-ready event.
+ * @param  sync: Pointer to ADXL_SyncType structure
+ * @param  now_us: Time of the DATA_READY edge
+ * @param  sample: The new sample, or NULL to take it from readLatest() at the next
+ *                 tick (FRESHEST only, with lowLatencyStart() reading each conversion)
+ * @return None
+ */
+void syncOnDataReady(ADXL_SyncType *sync, uint32_t now_us, const ADXL_SampleType *sample){
+	if(sync->dr_count > 0){
+		uint32_t period = now_us - sync->dr_us[1];
+		if(sync->odr_period_us == 0) sync->odr_period_us = period;
+		else sync->odr_period_us = sync->odr_period_us - (sync->odr_period_us >> 3) + (period >> 3);
+	}
+
+	/* An edge whose sample was never read leaves nothing to shift: the previous
+	 * slot stays unfilled until a later edge pushes a read sample into it */
+	sync->dr_us[0] = sync->dr_us[1];
+	sync->prev_filled = (uint8_t)(sync->dr_count > 0 && !sync->pending);
+	if(sync->prev_filled) sync->dr_sample[0] = sync->dr_sample[1];
+	sync->dr_us[1] = now_us;
+	if(sync->dr_count < 2) sync->dr_count++;
+
+	if(sample != NULL){
+		sync->dr_sample[1] = *sample;
+		sync->pending = 0;
+	}
+	else{
+		sync->pending = 1;
+	}
+
+	/* Phase of this conversion within the control period */
+	if(sync->ticks > 0 && sync->tick_period_us != 0){
+		int32_t phase = (int32_t)((now_us - sync->last_tick_us) % sync->tick_period_us);
+		sync->phase_us = phase;
+		if(phase < sync->phase_min_us) sync->phase_min_us = phase;
+		if(phase > sync->phase_max_us) sync->phase_max_us = phase;
+	}
+}
+
+/**
+ * @brief  Produces the sample for a control tick.
+ * @param  sync: Pointer to ADXL_SyncType structure
+ * @param  now_us: Time of the tick
+ * @param  out: Sample for the control loop
+ * @return 1 if 'out' is valid, 0 if no sample is available yet
+ */
+uint8_t syncOnTick(ADXL_SyncType *sync, uint32_t now_us, ADXL_SampleType *out){
+	uint32_t age;
+
+	if(sync->ticks > 0 && sync->dr_us[1] - sync->last_tick_us > now_us - sync->last_tick_us){
+		sync->stale++;                              //*No conversion since the previous tick
+	}
+	sync->last_tick_us = now_us;
+	sync->ticks++;
+
+	if(sync->dr_count == 0) return 0;
+
+	if(sync->mode == ADXL_SYNC_INTERPOLATE){
+		if(sync->dr_count < 2) return 0;
+
+		/* Query one ODR period back so it lies between the last two samples */
+		uint32_t span = sync->dr_us[1] - sync->dr_us[0];
+		uint32_t query = now_us - sync->odr_period_us;
+		int32_t t = (int32_t)(query - sync->dr_us[0]);
+
+		if(t < 0) t = 0;
+		if(span == 0 || (uint32_t)t > span) t = (int32_t)span;
+
+		int32_t frac = (span != 0) ? (int32_t)(((int64_t)t << 15) / span) : 32768;   //*Q15
+		const ADXL_SampleType *a = &sync->dr_sample[0];
+		const ADXL_SampleType *b = &sync->dr_sample[1];
+		out->x = (int16_t)(a->x + (((int64_t)(b->x - a->x) * frac) >> 15));
+		out->y = (int16_t)(a->y + (((int64_t)(b->y - a->y) * frac) >> 15));
+		out->z = (int16_t)(a->z + (((int64_t)(b->z - a->z) * frac) >> 15));
+		age = now_us - query;
+	}
+	else{
+		if(sync->pending){
+			/* Edge only: take the sample from the latest-sample cell (no bus access
+			 * in the timer interrupt). Until its read completes, the previous
+			 * sample is delivered with its own age. */
+			ADXL_SampleType latest;
+			uint32_t seq = readLatest(&latest);
+
+			if(seq != 0 && seq != sync->latest_seq){
+				sync->latest_seq = seq;
+				sync->dr_sample[1] = latest;
+				sync->pending = 0;
+			}
+		}
+
+		if(!sync->pending){
+			*out = sync->dr_sample[1];
+			age = now_us - sync->dr_us[1];
+		}
+		else{
+			if(!sync->prev_filled) return 0;
+			*out = sync->dr_sample[0];
+			age = now_us - sync->dr_us[0];
+		}
+	}
+
+	sync->age_us = age;
+	if(age > sync->age_max_us) sync->age_max_us = age;
+	sync->age_sum_us += age;
+	sync->delivered++;
+	return 1;
+}
+
+/**
+ * @brief  Mean age of the samples delivered at ticks.
+ * @param  sync: Pointer to ADXL_SyncType structure
+ * @return Microseconds
+ */
+uint32_t syncMeanAgeUs(const ADXL_SyncType *sync){
+	if(sync->delivered == 0) return 0;
+	return (uint32_t)(sync->age_sum_us / sync->delivered);
+}
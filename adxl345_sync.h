@@ -0,0 +1,86 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_sync.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Sampling aligned to a control-loop timer tick (adxl345_sync.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - The sensor runs off its own oscillator, the control loop off a hardware
+ *     timer: their relative phase drifts
+ *   - syncOnDataReady() is called on every data-ready event, syncOnTick() on
+ *     every control tick; both take a timestamp from the same microsecond clock
+ *   - ADXL_SYNC_FRESHEST: at the tick, deliver the newest sample (taking it from
+ *     readLatest() if only the DATA_READY edge was recorded; the tick never
+ *     touches the bus)
+ *   - ADXL_SYNC_INTERPOLATE: deliver the value at (tick - one ODR period),
+ *     linearly interpolated between the two samples around it: constant age,
+ *     no phase jitter
+ *   - Phase (data-ready relative to tick) and age-of-data are measured
+ *
+ *  @usage
+ *   syncInit(&sync, ADXL_SYNC_FRESHEST, 1000);                  // 1 kHz loop
+ *   lowLatencyStart(1, NULL);                                   // reads each conversion
+ *   EXTI:  ADXL_LowLatency_EXTI(); syncOnDataReady(&sync, micros(), NULL);   // edge only
+ *   TIM:   if(syncOnTick(&sync, micros(), &sample)) control(&sample);
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_SYNC_H_
+#define INC_ADXL345_SYNC_H_
+
+#include "adxl345.h"
+
+/* --------------------------------------------------
+ * 1. Sync setting value define
+ * --------------------------------------------------*/
+
+#define ADXL_SYNC_FRESHEST 0
+#define ADXL_SYNC_INTERPOLATE 1
+
+/* --------------------------------------------------
+ * 2. Sync Typedef
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint8_t mode;
+	uint32_t tick_period_us;
+
+	uint32_t last_tick_us;
+	uint32_t dr_us[2];               //*[0] previous, [1] newest data-ready time
+	ADXL_SampleType dr_sample[2];
+	uint8_t dr_count;                //*Samples recorded (saturates at 2)
+	uint8_t prev_filled;             //*dr_sample[0] was read (not an edge still pending)
+	volatile uint8_t pending;        //*Edge recorded, sample not read yet
+	uint32_t latest_seq;             //*readLatest() sequence last delivered
+	uint32_t odr_period_us;          //*Measured sample period (smoothed)
+
+	/* Statistics */
+	int32_t phase_us;                //*Last data-ready offset after the tick
+	int32_t phase_min_us;
+	int32_t phase_max_us;
+	uint32_t age_us;                 //*Age of the last delivered sample
+	uint32_t age_max_us;
+	uint64_t age_sum_us;
+	uint32_t ticks;
+	uint32_t delivered;              //*Ticks that produced a sample
+	uint32_t stale;                  //*Ticks without a new sample
+} ADXL_SyncType;
+
+/* --------------------------------------------------
+ * 3. function define
+ * --------------------------------------------------*/
+
+void syncInit(ADXL_SyncType *sync, uint8_t mode, uint32_t tick_period_us);
+void syncOnDataReady(ADXL_SyncType *sync, uint32_t now_us, const ADXL_SampleType *sample);
+uint8_t syncOnTick(ADXL_SyncType *sync, uint32_t now_us, ADXL_SampleType *out);
+uint32_t syncMeanAgeUs(const ADXL_SyncType *sync);
+
+#endif /* INC_ADXL345_SYNC_H_ */
@@ -0,0 +1,85 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_types.h
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       ADXL345 sample and block types (adxl345_types.h)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Plain data types shared by the driver and the host-side modules
+ *   - No HAL dependency: this header can be used on the MCU and on Linux
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#ifndef INC_ADXL345_TYPES_H_
+#define INC_ADXL345_TYPES_H_
+
+#include <stdint.h>
+
+/* --------------------------------------------------
+ * Sample / Block Typedef
+ * --------------------------------------------------*/
+
+#define ADXL_BLOCK_SAMPLES 32    //*One full FIFO (32 entries)
+
+typedef struct{
+	int16_t x;
+	int16_t y;
+	int16_t z;
+} ADXL_SampleType;
+
+typedef struct{
+	uint32_t seq;                                //*Block sequence number
+	uint16_t count;                              //*Number of valid samples
+	uint16_t node;                               //*Source sensor / stream id
+	uint16_t config_seq;                         //*Incremented by every reconfiguration
+	uint8_t data_format;                         //*DATA_FORMAT the samples were taken with
+	uint8_t bw_rate;                             //*BW_RATE the samples were taken with
+	uint8_t axes_off;                            //*ADXL_AXIS_xxx not used (0: all axes)
+	uint8_t reserved;
+	ADXL_SampleType samples[ADXL_BLOCK_SAMPLES];
+} ADXL_BlockType;
+
+/* --------------------------------------------------
+ * Health Status Typedef (adxl345_health.c, ADXL_FRAME_HEALTH)
+ * --------------------------------------------------*/
+
+#define ADXL_HEALTH_STUCK 1          //*An axis repeated one value for stuck_run samples
+#define ADXL_HEALTH_NOISE_HIGH 2     //*Noise floor above baseline * noise_ratio
+#define ADXL_HEALTH_NOISE_LOW 4      //*Noise floor below baseline / noise_ratio
+#define ADXL_HEALTH_SATURATED 8      //*Samples at full scale in the last window
+#define ADXL_HEALTH_DEVID 16         //*Last DEVID check failed (bus error or wrong ID)
+
+typedef struct{
+	uint8_t flags;                   //*ADXL_HEALTH_xxx, current
+	uint8_t latched;                 //*ADXL_HEALTH_xxx, since adxlHealthClear()
+	uint8_t stuck_axes;              //*ADXL_AXIS_xxx
+	uint8_t saturated_axes;          //*ADXL_AXIS_xxx
+	uint16_t noise[3];               //*Standard deviation of the last window, LSB in Q4
+	uint16_t floor[3];               //*Noise floor of the last floor period, LSB in Q4
+	uint16_t baseline[3];            //*Reference noise floor, LSB in Q4 (0: learning)
+	uint16_t max_run[3];             //*Longest run of identical samples, last window
+	uint32_t windows;
+	uint16_t devid_checks;
+	uint16_t devid_failures;
+} ADXL_HealthStatusType;
+
+/* --------------------------------------------------
+ * Duty Cycle Typedef (adxl345_idle.c, ADXL_FRAME_DUTY)
+ * --------------------------------------------------*/
+
+typedef struct{
+	uint32_t awake_us_per_s;
+	uint32_t wakeups_per_s;
+	uint32_t us_per_wakeup;          //*Mean awake time per wake-up
+	uint16_t duty_permille;          //*Awake fraction, 0 .. 1000
+} ADXL_DutyType;
+
+#endif /* INC_ADXL345_TYPES_H_ */
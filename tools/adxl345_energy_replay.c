@@ -0,0 +1,128 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_energy_replay.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Simulator replay: energy of FIFO watermark configurations (adxl345_energy_replay.c)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Runs 60 s of simulated time per configuration: FIFO in stream mode, the
+ *     MCU wakes on WATERMARK (polled every 1 ms of simulated time), counts the
+ *     wake-up with adxlEnergyWakeup() and drains the FIFO (blocking I2C)
+ *   - Prints the adxlEnergyReport() terms, the average current and the life on
+ *     a 220 mAh cell; the default model coefficients are used
+ *   - Without an argument the simulator's resting source (+1 g on Z) is used;
+ *     a recording is a text file of "x y z" lines in mg, replayed at 'rate' Hz
+ *     and looped
+ *
+ *  @usage
+ *   gcc -O2 -std=gnu11 -DADXL_USE_LINUX -I.. adxl345_energy_replay.c ../adxl345_energy.c \
+ *       ../adxl345.c ../adxl345_linux.c ../adxl345_sim.c -o energy_replay
+ *   ./energy_replay [recording.txt] [rate] | grep -v Success
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "adxl345_energy.h"
+#include "adxl345_sim.h"
+
+#define REPLAY_MS 60000
+#define REPLAY_MAX_SAMPLES 1000000
+
+typedef struct{
+	const char *name;
+	uint8_t bw_rate;
+	uint8_t lp_mode;
+	uint8_t watermark;               //*0: one wake-up per sample
+} ReplayConfigType;
+
+static const ReplayConfigType configs[] = {
+	{ "100 Hz, wm 16",    BWRATE_100, LP_NORMAL,   16 },
+	{ "100 Hz LP, wm 16", BWRATE_100, LP_LOWPOWER, 16 },
+	{ "100 Hz LP, wm 0",  BWRATE_100, LP_LOWPOWER, 0 },
+	{ "25 Hz LP, wm 25",  BWRATE_25,  LP_LOWPOWER, 25 },
+};
+
+static ADXL_SampleType *recording = NULL;
+static uint32_t recording_len = 0;
+static uint32_t recording_hz = 100;
+
+/**
+ * @brief  Simulator source: the recording, looped.
+ */
+static ADXL_SampleType recordingSource(uint64_t now_us){
+	return recording[(now_us * recording_hz / 1000000U) % recording_len];
+}
+
+/**
+ * @brief  Loads "x y z" lines (mg).
+ * @return 0 on success, -1 on failure
+ */
+static int loadRecording(const char *path){
+	FILE *f = fopen(path, "r");
+	int x, y, z;
+
+	if(f == NULL){
+		printf("Error: Cannot open %s\r\n", path);
+		return -1;
+	}
+	recording = malloc(sizeof(ADXL_SampleType) * REPLAY_MAX_SAMPLES);
+	while(recording_len < REPLAY_MAX_SAMPLES && fscanf(f, "%d %d %d", &x, &y, &z) == 3){
+		recording[recording_len++] = (ADXL_SampleType){ (int16_t)x, (int16_t)y, (int16_t)z };
+	}
+	fclose(f);
+
+	if(recording_len == 0){
+		printf("Error: No samples in %s\r\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief  Replays one configuration and prints its energy report.
+ */
+static void replay(const ReplayConfigType *cfg){
+	ADXL_InitType config = { .BWRATE = cfg->bw_rate, .LP_MODE = cfg->lp_mode, .MEASURE_SET = MEASURE_ON,
+			.FULL_RES = MODE_10BIT, .RANGE = RANGE_2G, .FIFO_MODE = FIFO_STREAM };
+	ADXL_EnergyType energy;
+	ADXL_EnergyReportType report;
+	ADXL_BlockType block;
+
+	adxlLinuxOpenSim(0);
+	adxlSimReset((recording != NULL) ? recordingSource : NULL);
+	adxlInit(&config);
+	writeRegister(FIFO_CTL, FIFO_STREAM | cfg->watermark);
+
+	adxlEnergyInit(&energy, NULL, (uint32_t)(adxlSim.now_us / 1000U));
+	for(uint32_t ms = 0; ms < REPLAY_MS; ms++){
+		adxlSimAdvance(1000);
+		if(adxlSim.reg[INT_SOURCE] & WATERMARK_INT){
+			adxlEnergyWakeup(&energy);
+			drainFifo(&block);
+		}
+	}
+	adxlEnergyReport(&energy, (uint32_t)(adxlSim.now_us / 1000U), &report);
+
+	printf("%-18s %8u %8u %8u %8u %8u %8u %8u\r\n", cfg->name, energy.wakeups, report.sensor_uj, report.bus_uj,
+			report.mcu_uj, report.total_uj, report.average_ua, adxlEnergyLifeHours(&report, 220));
+}
+
+int main(int argc, char **argv){
+	if(argc > 2) recording_hz = (uint32_t)strtoul(argv[2], NULL, 0);
+	if(argc > 1 && loadRecording(argv[1]) != 0) return 1;
+
+	printf("%-18s %8s %8s %8s %8s %8s %8s %8s\r\n", "config", "wakeups", "sensor", "bus", "mcu", "total",
+			"avg", "life");
+	printf("%-18s %8s %8s %8s %8s %8s %8s %8s\r\n", "", "", "uJ", "uJ", "uJ", "uJ", "uA", "h");
+	for(uint32_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) replay(&configs[i]);
+	return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_ingest_pty_test.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Pseudo-terminal harness for the epoll ingest (adxl345_ingest_pty_test.c)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Opens N pseudo-terminals; a writer thread sends block frames on every
+ *     slave side while adxlIngestRun() reads all master sides
+ *   - The ingest fans out into an ADXL_RING_DROP ring whose only consumer never
+ *     reads, so most blocks are dropped locally: no sequence gap may be reported
+ *   - Each port ends with one health frame, which must show up in its stream
+ *   - Prints frames, bytes, gaps and the per-frame cost; exits non-zero on error
+ *
+ *  @usage
+ *   gcc -O2 -std=gnu11 -pthread -I.. adxl345_ingest_pty_test.c ../adxl345_ingest.c \
+ *       ../adxl345_frame.c ../adxl345_ring.c ../adxl345_shm.c -o ingest_pty_test
+ *   ./ingest_pty_test [ports] [frames per port]
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "adxl345_ingest.h"
+
+#define MAX_PORTS 64
+
+static int ports = 8;
+static uint32_t frames_per_port = 2000;
+static int slave_fd[MAX_PORTS];
+
+static ADXL_IngestType ing;
+static ADXL_RingType ring;
+
+/**
+ * @brief  Opens one pseudo-terminal pair in raw mode.
+ * @param  slave: Receives the slave descriptor (written by the "sensor")
+ * @return Master descriptor (read by the ingest), or -1 on failure
+ */
+static int openPty(int *slave){
+	struct termios tio;
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) return -1;
+
+	*slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	if(*slave < 0) return -1;
+
+	if(tcgetattr(*slave, &tio) == 0){
+		cfmakeraw(&tio);
+		tcsetattr(*slave, TCSANOW, &tio);
+	}
+	return master;
+}
+
+/**
+ * @brief  Sends frames_per_port block frames on every port, interleaved.
+ */
+static void *writer(void *arg){
+	ADXL_BlockType block = { 0 };
+	uint8_t frame[ADXL_FRAME_MAX];
+
+	(void)arg;
+	block.count = ADXL_BLOCK_SAMPLES;
+
+	for(uint32_t n = 0; n < frames_per_port; n++){
+		for(int p = 0; p < ports; p++){
+			block.seq = n;
+			for(uint16_t i = 0; i < block.count; i++) block.samples[i].x = (int16_t)(n + i);
+
+			uint16_t len = adxlFrameEncodeBlock(&block, frame);
+			for(uint16_t off = 0; off < len;){
+				ssize_t w = write(slave_fd[p], frame + off, len - off);
+				if(w > 0) off += (uint16_t)w;
+			}
+		}
+	}
+
+	/* One health summary per port, tagged with the port number */
+	for(int p = 0; p < ports; p++){
+		ADXL_HealthStatusType health = { .flags = ADXL_HEALTH_STUCK, .windows = (uint32_t)p };
+		uint16_t len = adxlHealthEncode(&health, frame);
+		for(uint16_t off = 0; off < len;){
+			ssize_t w = write(slave_fd[p], frame + off, len - off);
+			if(w > 0) off += (uint16_t)w;
+		}
+	}
+
+	for(int p = 0; p < ports; p++) close(slave_fd[p]);
+	return NULL;
+}
+
+int main(int argc, char **argv){
+	pthread_t tid;
+	uint32_t gaps = 0, crc_errors = 0, health_errors = 0;
+
+	if(argc > 1) ports = atoi(argv[1]);
+	if(argc > 2) frames_per_port = (uint32_t)strtoul(argv[2], NULL, 0);
+	if(ports < 1 || ports > MAX_PORTS) ports = 8;
+
+	adxlRingInit(&ring, ADXL_RING_DROP, NULL);
+	adxlRingAddConsumer(&ring);                     //*Never reads: the ring fills up
+	if(adxlIngestInit(&ing, &ring, NULL) != 0) return 1;
+
+	for(int p = 0; p < ports; p++){
+		int master = openPty(&slave_fd[p]);
+		if(adxlIngestAdd(&ing, master, (uint16_t)p) < 0){
+			printf("Error: Failed to add pty %d\r\n", p);
+			return 1;
+		}
+	}
+
+	pthread_create(&tid, NULL, writer, NULL);
+	while(ing.frames < (uint64_t)ports * (frames_per_port + 1)){
+		if(adxlIngestRun(&ing, 1000) <= 0) break;
+	}
+	pthread_join(tid, NULL);
+
+	for(int p = 0; p < ports; p++){
+		gaps += ing.stream[p].gaps;
+		crc_errors += ing.stream[p].dec.crc_errors;
+		if(ing.stream[p].health_frames != 1 || ing.stream[p].health.windows != (uint32_t)p) health_errors++;
+	}
+
+	printf("%d ports: %llu frames, %llu bytes, %u gaps, %u crc errors, %u health errors, %u dropped, %u ns/frame\r\n",
+			ports, (unsigned long long)ing.frames, (unsigned long long)ing.bytes,
+			gaps, crc_errors, health_errors, ring.dropped, adxlIngestFrameCostNs(&ing));
+
+	int failed = ing.frames != (uint64_t)ports * (frames_per_port + 1) || gaps != 0 || crc_errors != 0 || health_errors != 0;
+	adxlIngestClose(&ing);
+	return failed;
+}
@@ -0,0 +1,108 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_pipeline_bench.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Host benchmark: fused kernel vs staged pipeline (adxl345_pipeline_bench.c)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Two pipelines over the same pseudo-random raw blocks:
+ *     staged (convert, calibrate, filter, stats) and fused (adxlStageFused)
+ *   - Each pipeline has its own filter state, so both see an unbroken stream
+ *   - Outputs and window statistics must match exactly; per-stage times are
+ *     taken from <name>_cycles[] (ns on Linux)
+ *
+ *  @usage
+ *   gcc -O2 -std=gnu11 -DADXL_USE_LINUX -I.. adxl345_pipeline_bench.c ../adxl345_pipeline.c \
+ *       ../adxl345.c ../adxl345_linux.c ../adxl345_sim.c -o pipeline_bench
+ *   ./pipeline_bench [blocks] [offdiag]
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "adxl345_pipeline.h"
+
+static ADXL_BlockType source;
+static ADXL_StatsType staged_stats, fused_stats;
+
+/** Copies the current raw block, so both pipelines process identical input */
+static void benchSource(ADXL_BlockType *block){
+	memcpy(block->samples, source.samples, sizeof(source.samples));
+	block->data_format = source.data_format;
+	block->axes_off = 0;
+}
+
+#define STAGED_STAGES(X, a) \
+	X(a, benchSource, 1) \
+	X(a, adxlStageConvert, 1) \
+	X(a, adxlStageCalibrate, 1) \
+	X(a, adxlStageFilter, 1) \
+	X(a, adxlStageStats, 1)
+
+#define FUSED_STAGES(X, a) \
+	X(a, benchSource, 1) \
+	X(a, adxlStageFused, 1)
+
+ADXL_PIPELINE_DEFINE(staged, ADXL_BLOCK_SAMPLES, STAGED_STAGES)
+ADXL_PIPELINE_DEFINE(fused, ADXL_BLOCK_SAMPLES, FUSED_STAGES)
+
+static void report(const char *name, const char * const *names, const uint32_t *cycles,
+		uint8_t stages, uint32_t blocks){
+	uint64_t total = 0;
+
+	for(uint8_t i = 1; i < stages; i++){                //*Stage 0 is the copy
+		printf("  %-8s %-20s %8.1f ns/block\r\n", name, names[i], (double)cycles[i] / blocks);
+		total += cycles[i];
+	}
+	printf("  %-8s %-20s %8.1f ns/block\r\n", name, "total", (double)total / blocks);
+}
+
+int main(int argc, char **argv){
+	uint32_t blocks = 200000;
+	uint32_t mismatches = 0;
+
+	if(argc > 1) blocks = (uint32_t)strtoul(argv[1], NULL, 0);
+
+	adxlCalib.offset[0] = 12;
+	adxlCalib.matrix[1][1] = 17000;
+	if(argc > 2) adxlCalib.matrix[0][1] = 300;      //*Forces the full-matrix path
+
+	source.data_format = FULL_RESOLUTION | RANGE_4G;
+	adxlStatsReset(&staged_stats);
+	adxlStatsReset(&fused_stats);
+	srand(1);
+
+	for(uint32_t n = 0; n < blocks; n++){
+		for(uint16_t i = 0; i < ADXL_BLOCK_SAMPLES; i++){
+			source.samples[i].x = (int16_t)(rand() % 1000 - 500);
+			source.samples[i].y = (int16_t)(rand() % 1000 - 500);
+			source.samples[i].z = (int16_t)(rand() % 1000);
+		}
+
+		adxlStats = staged_stats;
+		staged_run();
+		staged_stats = adxlStats;
+
+		adxlStats = fused_stats;
+		fused_run();
+		fused_stats = adxlStats;
+
+		if(memcmp(staged_block.samples, fused_block.samples, sizeof(staged_block.samples)) != 0) mismatches++;
+	}
+	if(memcmp(&staged_stats, &fused_stats, sizeof(ADXL_StatsType)) != 0) mismatches++;
+
+	printf("%u blocks of %d samples, %s matrix\r\n", blocks, ADXL_BLOCK_SAMPLES, (argc > 2) ? "full" : "diagonal");
+	report("staged", staged_names, staged_cycles, sizeof(staged_names) / sizeof(staged_names[0]), blocks);
+	report("fused", fused_names, fused_cycles, sizeof(fused_names) / sizeof(fused_names[0]), blocks);
+	printf("mismatches %u\r\n", mismatches);
+	return mismatches != 0;
+}
@@ -0,0 +1,127 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_profile_bench.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Simulator benchmark: profile switch cost (adxl345_profile_bench.c)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - Three profiles over one base image: "idle", "vibration" (rate, range and
+ *     FIFO change: measurement pauses) and "tap" (thresholds only)
+ *   - Every (from, to) switch is timed on the simulated bus (adxlSim.bus_us,
+ *     400 kHz I2C) and compared with writing each changed register on its own
+ *     (one transaction per register, same pause and FIFO drain)
+ *   - The FIFO is drained right before each switch, so a pause costs one
+ *     FIFO_STATUS read instead of a full drain
+ *   - Checks that the shadow image equals the target profile after every switch
+ *
+ *  @usage
+ *   gcc -O2 -std=gnu11 -DADXL_USE_LINUX -I.. adxl345_profile_bench.c ../adxl345_profile.c \
+ *       ../adxl345.c ../adxl345_linux.c ../adxl345_sim.c -o profile_bench
+ *   ./profile_bench | grep -v Success
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "adxl345_profile.h"
+#include "adxl345_sim.h"
+
+#define PROFILES 3
+
+/** Same rule as adxl345_profile.c: writable and not POWER_CTL */
+static uint8_t burstableReg(uint8_t reg){
+	if(reg == ACT_TAP_STATUS || reg == INT_SOURCE || reg == POWER_CTL) return 0;
+	return (uint8_t)(reg < DATAX0 || reg > DATAZ1);
+}
+
+static ADXL_ProfileType profiles[PROFILES];
+
+/**
+ * @brief  Naive switch: one single-register write per changed register.
+ * @param  to: Target image
+ * @param  tail: Receives the drained FIFO when measurement pauses
+ * @return None
+ */
+static void naiveSwitch(const uint8_t *to, ADXL_BlockType *tail){
+	ADXL_BurstPlanType plan;
+	uint8_t standby;
+	uint8_t image[ADXL_SHADOW_SIZE];
+
+	memcpy(image, getShadow(), ADXL_SHADOW_SIZE);
+	adxlProfilePlan(image, to, &plan);
+	standby = image[ADXL_REG(POWER_CTL)] & (uint8_t)~MEASURE_ON;
+
+	if(plan.pause){
+		drainFifo(tail);
+		writeBurst(POWER_CTL, &standby, 1);
+	}
+	for(uint8_t reg = ADXL_SHADOW_FIRST; reg <= ADXL_SHADOW_LAST; reg++){
+		if(burstableReg(reg) && image[ADXL_REG(reg)] != to[ADXL_REG(reg)]) writeBurst(reg, &to[ADXL_REG(reg)], 1);
+	}
+	if(plan.pause || plan.power_ctl) writeBurst(POWER_CTL, &to[ADXL_REG(POWER_CTL)], 1);
+}
+
+int main(void){
+	ADXL_InitType config = { .BWRATE = BWRATE_100, .MEASURE_SET = MEASURE_ON, .FULL_RES = MODE_10BIT,
+			.RANGE = RANGE_2G, .FIFO_MODE = FIFO_STREAM };
+	ADXL_BlockType tail;
+	uint32_t mismatches = 0;
+
+	adxlLinuxOpenSim(0);
+	adxlInit(&config);
+	adxlSimAdvance(100000);
+
+	for(uint8_t i = 0; i < PROFILES; i++) memcpy(profiles[i].image, getShadow(), ADXL_SHADOW_SIZE);
+	profiles[0].name = "idle";
+	profiles[1].name = "vibration";
+	profiles[1].image[ADXL_REG(BW_RATE)] = BWRATE_1600;
+	profiles[1].image[ADXL_REG(DATA_FORMAT)] |= FULL_RESOLUTION | RANGE_16G;
+	profiles[1].image[ADXL_REG(FIFO_CTL)] = FIFO_STREAM | 16;
+	profiles[2].name = "tap";
+	profiles[2].image[ADXL_REG(THRESH_TAP)] = 40;
+	profiles[2].image[ADXL_REG(DUR)] = 10;
+	profiles[2].image[ADXL_REG(THRESH_ACT)] = 5;
+	profiles[2].image[ADXL_REG(TIME_INACT)] = 3;
+	adxlProfileRegister(profiles, PROFILES);
+	adxlProfileSwitch(0, &tail);
+
+	printf("%-10s -> %-10s %6s %8s %10s %10s\r\n", "from", "to", "tx", "bus us", "naive tx", "naive us");
+	for(uint8_t from = 0; from < PROFILES; from++){
+		for(uint8_t to = 0; to < PROFILES; to++){
+			if(from == to) continue;
+			/* Naive switch, measured the same way */
+			adxlProfileSwitch(from, &tail);
+			drainFifo(&tail);
+			uint32_t tx0 = adxlSim.transactions;
+			uint64_t us0 = adxlSim.bus_us;
+			naiveSwitch(profiles[to].image, &tail);
+			uint32_t naive_tx = adxlSim.transactions - tx0;
+			uint64_t naive_us = adxlSim.bus_us - us0;
+			if(memcmp(getShadow(), profiles[to].image, ADXL_SHADOW_SIZE) != 0) mismatches++;
+
+			/* Planned switch */
+			adxlProfileSwitch(from, &tail);
+			drainFifo(&tail);
+			tx0 = adxlSim.transactions;
+			us0 = adxlSim.bus_us;
+			uint8_t n = adxlProfileSwitch(to, &tail);
+			uint32_t tx = adxlSim.transactions - tx0;
+			uint64_t us = adxlSim.bus_us - us0;
+
+			if(n == ADXL_PROFILE_ERROR || memcmp(getShadow(), profiles[to].image, ADXL_SHADOW_SIZE) != 0) mismatches++;
+			printf("%-10s -> %-10s %6u %8llu %10u %10llu\r\n", profiles[from].name, profiles[to].name,
+					tx, (unsigned long long)us, naive_tx, (unsigned long long)naive_us);
+		}
+	}
+
+	printf("mismatches %u\r\n", mismatches);
+	return mismatches != 0;
+}
@@ -0,0 +1,122 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_ring_bench.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Host benchmark for the block ring (adxl345_ring_bench.c)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - One producer thread, 1 / 4 / 16 consumer threads, ADXL_RING_BLOCK policy
+ *   - Every consumer checks that it sees every block in order
+ *   - Prints blocks per second and the time per block for each run
+ *
+ *  @usage
+ *   gcc -O2 -std=gnu11 -pthread -I.. adxl345_ring_bench.c ../adxl345_ring.c -o ring_bench
+ *   ./ring_bench [blocks]
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "adxl345_ring.h"
+
+static ADXL_RingType ring;
+static uint32_t total_blocks = 2000000;
+
+typedef struct{
+	int id;
+	uint32_t errors;
+	uint64_t checksum;
+} ConsumerType;
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void yield(void){
+	sched_yield();
+}
+
+static void *producer(void *arg){
+	(void)arg;
+
+	for(uint32_t n = 0; n < total_blocks; n++){
+		ADXL_BlockType *b = adxlRingClaim(&ring);
+		b->count = 1;
+		b->samples[0].x = (int16_t)n;
+		adxlRingPublish(&ring);
+	}
+	return NULL;
+}
+
+static void *consumer(void *arg){
+	ConsumerType *c = arg;
+	uint32_t expect = 0;
+
+	while(expect < total_blocks){
+		uint32_t n = adxlRingAvailable(&ring, c->id);
+		if(n == 0){
+			yield();
+			continue;
+		}
+		for(uint32_t i = 0; i < n; i++){
+			const ADXL_BlockType *b = adxlRingGet(&ring, c->id, i);
+			if(b->seq != expect || b->samples[0].x != (int16_t)expect) c->errors++;
+			c->checksum += (uint16_t)b->samples[0].x;
+			expect++;
+		}
+		adxlRingRelease(&ring, c->id, n);
+	}
+	return NULL;
+}
+
+static int run(int consumers){
+	pthread_t prod, cons[ADXL_RING_MAX_CONSUMERS];
+	ConsumerType ctx[ADXL_RING_MAX_CONSUMERS];
+	uint32_t errors = 0;
+
+	adxlRingInit(&ring, ADXL_RING_BLOCK, yield);
+	for(int i = 0; i < consumers; i++){
+		ctx[i].id = adxlRingAddConsumer(&ring);
+		ctx[i].errors = 0;
+		ctx[i].checksum = 0;
+	}
+
+	double t0 = nowSeconds();
+	for(int i = 0; i < consumers; i++) pthread_create(&cons[i], NULL, consumer, &ctx[i]);
+	pthread_create(&prod, NULL, producer, NULL);
+
+	pthread_join(prod, NULL);
+	for(int i = 0; i < consumers; i++){
+		pthread_join(cons[i], NULL);
+		errors += ctx[i].errors;
+	}
+	double dt = nowSeconds() - t0;
+
+	printf("%2d consumers: %10.0f blocks/s  %7.1f ns/block  errors %u\r\n",
+			consumers, total_blocks / dt, dt * 1e9 / total_blocks, errors);
+	return errors != 0;
+}
+
+int main(int argc, char **argv){
+	int failed = 0;
+
+	if(argc > 1) total_blocks = (uint32_t)strtoul(argv[1], NULL, 0);
+
+	failed |= run(1);
+	failed |= run(4);
+	failed |= run(16);
+	return failed;
+}
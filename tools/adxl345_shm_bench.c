@@ -0,0 +1,243 @@
+/**
+ *******************************************************************************
+ *
+ *  @file        adxl345_shm_bench.c
+ *  @author      HyunJoong Kim (Github: Hyunjoongcode)
+ *  @brief       Host benchmark: shared-memory publication vs a pipe (adxl345_shm_bench.c)
+ *
+ *******************************************************************************
+ *
+ *  @details
+ *   - The publisher (parent) sends blocks to a subscriber process (fork) over
+ *     adxl345_shm (futex wake-up, read in place) and over a pipe (one
+ *     sizeof(ADXL_BlockType) write/read per block)
+ *   - Latency: one block every 'period' us, stamped with CLOCK_MONOTONIC just
+ *     before it is published; the subscriber reports min / mean / p99 / max
+ *   - Throughput: blocks as fast as the publisher can go; the shm subscriber
+ *     may fall behind (overruns are counted), the pipe blocks the writer.
+ *     The shm publisher cost per block is printed as well
+ *   - Run on an idle multi-core host: on one CPU every futex wake-up preempts
+ *     the publisher and the figures mostly measure the scheduler
+ *
+ *  @usage
+ *   gcc -O2 -std=gnu11 -I.. adxl345_shm_bench.c ../adxl345_shm.c ../adxl345_shm_sub.c \
+ *       ../adxl345_ring.c -o shm_bench
+ *   ./shm_bench [latency blocks] [period us] [throughput blocks]
+ *
+ *******************************************************************************
+ *
+ * @license MIT License
+ *
+ *******************************************************************************
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "adxl345_shm.h"
+
+#define BENCH_NAME "bench"
+#define MAX_SAMPLES 1000000
+
+static uint32_t latency_blocks = 20000;
+static uint32_t period_us = 100;
+static uint32_t throughput_blocks = 2000000;
+
+static uint64_t nowNs(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void spinUntil(uint64_t t){
+	while(nowNs() < t);
+}
+
+/** The timestamp travels in the first sample slots of the block */
+static void stamp(ADXL_BlockType *block, uint32_t n, uint8_t last){
+	uint64_t t = nowNs();
+
+	block->count = last ? 0 : 1;                     //*count 0: end of run
+	block->config_seq = (uint16_t)n;
+	memcpy(block->samples, &t, sizeof(t));
+}
+
+static uint64_t stampOf(const ADXL_BlockType *block){
+	uint64_t t;
+	memcpy(&t, block->samples, sizeof(t));
+	return t;
+}
+
+static int compareU32(const void *a, const void *b){
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief  Prints latency statistics (ns) of one transport.
+ */
+static void report(const char *name, uint32_t *lat, uint32_t n, uint32_t lost, double seconds){
+	uint64_t sum = 0;
+
+	if(n == 0){
+		printf("  %-5s no blocks received\r\n", name);
+		return;
+	}
+	qsort(lat, n, sizeof(lat[0]), compareU32);
+	for(uint32_t i = 0; i < n; i++) sum += lat[i];
+
+	if(seconds > 0){
+		printf("  %-5s %10.0f blocks/s  %7.1f ns/block  lost %u\r\n", name, n / seconds, seconds * 1e9 / n, lost);
+	}
+	else{
+		printf("  %-5s latency ns: min %u  mean %llu  p99 %u  max %u  lost %u\r\n", name, lat[0],
+				(unsigned long long)(sum / n), lat[(uint64_t)n * 99 / 100], lat[n - 1], lost);
+	}
+}
+
+/* --------------------------------------------------
+ * Shared memory
+ * --------------------------------------------------*/
+
+static void shmSubscriber(uint32_t *lat, uint8_t timed){
+	ADXL_ShmSubType sub;
+	uint32_t n = 0, done = 0;
+	uint64_t t0 = 0, t_last = 0;
+
+	if(adxlShmSubscribe(&sub, BENCH_NAME) != 0) exit(1);
+
+	while(!done){
+		uint32_t avail = adxlShmWait(&sub, 1000);
+		if(avail == 0) break;                        //*Publisher gone (end marker overwritten)
+
+		for(uint32_t i = 0; i < avail; i++){
+			const ADXL_BlockType *b = adxlShmGet(&sub, i);
+			uint64_t sent = stampOf(b);
+			uint8_t last = (uint8_t)(b->count == 0);
+			uint64_t now = nowNs();
+
+			if(!adxlShmValid(&sub, i)) continue;
+			if(t0 == 0) t0 = now;
+			t_last = now;
+			if(last){
+				done = 1;
+				break;
+			}
+			if(n < MAX_SAMPLES) lat[n++] = (uint32_t)(now - sent);
+		}
+		adxlShmRelease(&sub, avail);
+	}
+
+	report("shm", lat, n, sub.overruns, timed ? (double)(t_last - t0) * 1e-9 : 0);
+	adxlShmUnsubscribe(&sub);
+}
+
+static void shmRun(uint32_t blocks, uint32_t period, uint32_t *lat, uint8_t timed){
+	ADXL_ShmPubType pub;
+	pid_t pid;
+
+	if(adxlShmCreate(&pub, BENCH_NAME) != 0) exit(1);
+
+	pid = fork();
+	if(pid == 0){
+		shmSubscriber(lat, timed);
+		exit(0);
+	}
+	usleep(100000);                                  //*Let the subscriber go to sleep
+
+	uint64_t t0 = nowNs(), next = t0;
+	for(uint32_t n = 0; n <= blocks; n++){
+		if(period != 0){
+			next += (uint64_t)period * 1000U;
+			spinUntil(next);
+		}
+		stamp(adxlShmClaim(&pub), n, (uint8_t)(n == blocks));
+		adxlShmPublish(&pub);
+	}
+	if(timed) printf("  shm   publisher %7.1f ns/block\r\n", (double)(nowNs() - t0) / (blocks + 1));
+	fflush(stdout);
+	waitpid(pid, NULL, 0);
+	adxlShmDestroy(&pub);
+}
+
+/* --------------------------------------------------
+ * Pipe
+ * --------------------------------------------------*/
+
+static void pipeSubscriber(int fd, uint32_t *lat, uint8_t timed){
+	ADXL_BlockType block;
+	uint32_t n = 0;
+	uint64_t t0 = 0;
+
+	for(;;){
+		size_t got = 0;
+		while(got < sizeof(block)){
+			ssize_t r = read(fd, (uint8_t *)&block + got, sizeof(block) - got);
+			if(r <= 0) goto end;
+			got += (size_t)r;
+		}
+		uint64_t now = nowNs();
+		if(t0 == 0) t0 = now;
+		if(block.count == 0) break;
+		if(n < MAX_SAMPLES) lat[n++] = (uint32_t)(now - stampOf(&block));
+	}
+end:
+	report("pipe", lat, n, 0, timed ? (double)(nowNs() - t0) * 1e-9 : 0);
+}
+
+static void pipeRun(uint32_t blocks, uint32_t period, uint32_t *lat, uint8_t timed){
+	ADXL_BlockType block = { 0 };
+	int fd[2];
+	pid_t pid;
+
+	if(pipe(fd) != 0) exit(1);
+
+	pid = fork();
+	if(pid == 0){
+		close(fd[1]);
+		pipeSubscriber(fd[0], lat, timed);
+		exit(0);
+	}
+	close(fd[0]);
+	usleep(100000);
+
+	uint64_t next = nowNs();
+	for(uint32_t n = 0; n <= blocks; n++){
+		if(period != 0){
+			next += (uint64_t)period * 1000U;
+			spinUntil(next);
+		}
+		stamp(&block, n, (uint8_t)(n == blocks));
+		for(size_t off = 0; off < sizeof(block);){
+			ssize_t w = write(fd[1], (uint8_t *)&block + off, sizeof(block) - off);
+			if(w <= 0) exit(1);
+			off += (size_t)w;
+		}
+	}
+	close(fd[1]);
+	waitpid(pid, NULL, 0);
+}
+
+int main(int argc, char **argv){
+	static uint32_t lat[MAX_SAMPLES];
+
+	if(argc > 1) latency_blocks = (uint32_t)strtoul(argv[1], NULL, 0);
+	if(argc > 2) period_us = (uint32_t)strtoul(argv[2], NULL, 0);
+	if(argc > 3) throughput_blocks = (uint32_t)strtoul(argv[3], NULL, 0);
+
+	printf("%u-byte blocks, latency: %u blocks every %u us\r\n",
+			(unsigned)sizeof(ADXL_BlockType), latency_blocks, period_us);
+	fflush(stdout);
+	shmRun(latency_blocks, period_us, lat, 0);
+	pipeRun(latency_blocks, period_us, lat, 0);
+
+	printf("throughput: %u blocks, unpaced\r\n", throughput_blocks);
+	fflush(stdout);
+	shmRun(throughput_blocks, 0, lat, 1);
+	pipeRun(throughput_blocks, 0, lat, 1);
+	return 0;
+}